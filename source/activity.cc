@@ -0,0 +1,277 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "activity.h"
+
+#include "counters.h"
+
+// Global Variables
+TweakActivity activity;
+
+// content watched on one notebook page
+struct TweakActivityPage {
+  GtkNotebook *notebook = nullptr;
+  GtkWidget *page = nullptr;
+
+  // the page, when it holds the content directly and may replace it
+  GtkWidget *container = nullptr;
+  gulong add_handler = 0;
+  gulong remove_handler = 0;
+
+  GObject *source = nullptr;  // tree model, text buffer, or terminal
+  gulong source_handler = 0;
+
+  gboolean shown = false;
+  gboolean marked = false;
+  gboolean blocked = false;
+};
+
+static GQuark activity_quark() {
+  static GQuark quark = g_quark_from_static_string("xitweaks-activity");
+  return quark;
+}
+
+// tree views for the compiler, messages, and most sidebar pages, text views
+// for the scribble, and anything else that reports "contents-changed", such
+// as the terminal
+static GtkWidget *find_content(GtkWidget *widget) {
+  if (GTK_IS_TREE_VIEW(widget) || GTK_IS_TEXT_VIEW(widget) ||
+      g_signal_lookup("contents-changed", G_OBJECT_TYPE(widget)) != 0) {
+    return widget;
+  }
+  if (!GTK_IS_CONTAINER(widget)) {
+    return nullptr;
+  }
+
+  GtkWidget *content = nullptr;
+  GList *children = gtk_container_get_children(GTK_CONTAINER(widget));
+  for (GList *item = children; item != nullptr && content == nullptr;
+       item = item->next) {
+    content = find_content(GTK_WIDGET(item->data));
+  }
+  g_list_free(children);
+
+  return content;
+}
+
+static void activity_sync(TweakActivityPage *state) {
+  gboolean block = state->shown || state->marked;
+  if (state->source == nullptr || state->blocked == block) {
+    return;
+  }
+
+  if (block) {
+    g_signal_handler_block(state->source, state->source_handler);
+  } else {
+    g_signal_handler_unblock(state->source, state->source_handler);
+  }
+  state->blocked = block;
+}
+
+// The label is looked up only here, once per change of state.
+static void activity_set_marked(TweakActivityPage *state, gboolean marked) {
+  if (state->marked == marked) {
+    return;
+  }
+  state->marked = marked;
+
+  GtkWidget *label = gtk_notebook_get_tab_label(state->notebook, state->page);
+  if (label != nullptr) {
+    GtkStyleContext *context = gtk_widget_get_style_context(label);
+    if (marked) {
+      gtk_style_context_add_class(context, "xitweaks-activity");
+    } else {
+      gtk_style_context_remove_class(context, "xitweaks-activity");
+    }
+  }
+
+  activity_sync(state);
+}
+
+// the first change since the page was hidden; blocked until it is shown
+static void on_content_changed(TweakActivityPage *state) {
+  counters.activity_marks++;
+  activity_set_marked(state, true);
+}
+
+static void activity_attach(TweakActivityPage *state, gpointer source,
+                            char const *signal) {
+  if (source == nullptr) {
+    return;
+  }
+
+  state->source = G_OBJECT(g_object_ref(source));
+  state->source_handler = g_signal_connect_swapped(
+      source, signal, G_CALLBACK(on_content_changed), state);
+  state->blocked = false;
+  activity_sync(state);
+}
+
+static void activity_detach(TweakActivityPage *state) {
+  if (state->source == nullptr) {
+    return;
+  }
+
+  g_signal_handler_disconnect(state->source, state->source_handler);
+  g_object_unref(state->source);
+  state->source = nullptr;
+  state->source_handler = 0;
+  state->blocked = false;
+}
+
+static void activity_attach_content(TweakActivityPage *state,
+                                    GtkWidget *content) {
+  if (content == nullptr) {
+    // nothing to watch
+  } else if (GTK_IS_TREE_VIEW(content)) {
+    activity_attach(state, gtk_tree_view_get_model(GTK_TREE_VIEW(content)),
+                    "row-inserted");
+  } else if (GTK_IS_TEXT_VIEW(content)) {
+    activity_attach(state, gtk_text_view_get_buffer(GTK_TEXT_VIEW(content)),
+                    "changed");
+  } else {
+    activity_attach(state, content, "contents-changed");
+  }
+}
+
+// Geany swaps a tree view per document into the symbols page.
+static void on_content_replaced(TweakActivityPage *state) {
+  activity_detach(state);
+  activity_attach_content(state, find_content(state->container));
+}
+
+static void activity_free(gpointer data) {
+  auto *state = static_cast<TweakActivityPage *>(data);
+
+  activity_detach(state);
+  if (state->container != nullptr) {
+    g_signal_handler_disconnect(state->container, state->add_handler);
+    g_signal_handler_disconnect(state->container, state->remove_handler);
+  }
+
+  delete state;
+}
+
+// Functions
+
+void TweakActivity::update(gboolean enable) {
+  if (enable && watched.empty()) {
+    watch(GTK_NOTEBOOK(geany_data->main_widgets->sidebar_notebook));
+    watch(GTK_NOTEBOOK(geany_data->main_widgets->message_window_notebook));
+  } else if (!enable) {
+    clear();
+  }
+}
+
+void TweakActivity::clear() {
+  for (TweakActivityNotebook &entry : watched) {
+    for (gulong handler : entry.handlers) {
+      g_signal_handler_disconnect(entry.notebook, handler);
+    }
+
+    GList *pages = gtk_container_get_children(GTK_CONTAINER(entry.notebook));
+    for (GList *item = pages; item != nullptr; item = item->next) {
+      unbind(GTK_WIDGET(item->data));
+    }
+    g_list_free(pages);
+  }
+  watched.clear();
+}
+
+void TweakActivity::watch(GtkNotebook *notebook) {
+  TweakActivityNotebook entry;
+  entry.notebook = notebook;
+
+  entry.handlers.push_back(g_signal_connect(
+      notebook, "page-added", G_CALLBACK(on_page_added), nullptr));
+  entry.handlers.push_back(g_signal_connect(
+      notebook, "page-removed", G_CALLBACK(on_page_removed), nullptr));
+  entry.handlers.push_back(g_signal_connect(
+      notebook, "switch-page", G_CALLBACK(on_switch_page), nullptr));
+
+  GtkWidget *current = gtk_notebook_get_nth_page(
+      notebook, gtk_notebook_get_current_page(notebook));
+
+  GList *pages = gtk_container_get_children(GTK_CONTAINER(notebook));
+  for (GList *item = pages; item != nullptr; item = item->next) {
+    bind(notebook, GTK_WIDGET(item->data), item->data == current);
+  }
+  g_list_free(pages);
+
+  watched.push_back(entry);
+}
+
+void TweakActivity::bind(GtkNotebook *notebook, GtkWidget *page,
+                         gboolean shown) {
+  if (g_object_get_qdata(G_OBJECT(page), activity_quark()) != nullptr) {
+    return;
+  }
+
+  auto *state = new TweakActivityPage();
+  state->notebook = notebook;
+  state->page = page;
+  state->shown = shown;
+
+  // The handlers on the page go with its state, so the page outlives them.
+  GtkWidget *content = find_content(page);
+  if (GTK_IS_CONTAINER(page) &&
+      (content == nullptr || gtk_widget_get_parent(content) == page)) {
+    state->container = page;
+  }
+  if (state->container != nullptr) {
+    state->add_handler = g_signal_connect_data(
+        state->container, "add", G_CALLBACK(on_content_replaced), state,
+        nullptr, GConnectFlags(G_CONNECT_SWAPPED | G_CONNECT_AFTER));
+    state->remove_handler = g_signal_connect_data(
+        state->container, "remove", G_CALLBACK(on_content_replaced), state,
+        nullptr, GConnectFlags(G_CONNECT_SWAPPED | G_CONNECT_AFTER));
+  }
+  activity_attach_content(state, content);
+
+  g_object_set_qdata_full(G_OBJECT(page), activity_quark(), state,
+                          activity_free);
+}
+
+void TweakActivity::unbind(GtkWidget *page) {
+  auto *state = static_cast<TweakActivityPage *>(
+      g_object_get_qdata(G_OBJECT(page), activity_quark()));
+  if (state != nullptr) {
+    activity_set_marked(state, false);
+    g_object_set_qdata(G_OBJECT(page), activity_quark(), nullptr);
+  }
+}
+
+void TweakActivity::on_page_added(GtkNotebook *notebook, GtkWidget *page,
+                                  guint page_num, gpointer user_data) {
+  bind(notebook, page,
+       gint(page_num) == gtk_notebook_get_current_page(notebook));
+}
+
+// the tab label has gone with the page
+void TweakActivity::on_page_removed(GtkNotebook *notebook, GtkWidget *page,
+                                    guint page_num, gpointer user_data) {
+  g_object_set_qdata(G_OBJECT(page), activity_quark(), nullptr);
+}
+
+// Runs before the notebook switches, so the current page is the old one.
+void TweakActivity::on_switch_page(GtkNotebook *notebook, GtkWidget *page,
+                                   guint page_num, gpointer user_data) {
+  GtkWidget *old_page = gtk_notebook_get_nth_page(
+      notebook, gtk_notebook_get_current_page(notebook));
+
+  auto *state = old_page != nullptr
+                    ? static_cast<TweakActivityPage *>(g_object_get_qdata(
+                          G_OBJECT(old_page), activity_quark()))
+                    : nullptr;
+  if (state != nullptr && old_page != page) {
+    state->shown = false;
+    activity_sync(state);
+  }
+
+  state = static_cast<TweakActivityPage *>(
+      g_object_get_qdata(G_OBJECT(page), activity_quark()));
+  if (state != nullptr) {
+    state->shown = true;
+    activity_set_marked(state, false);
+    activity_sync(state);
+  }
+}
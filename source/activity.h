@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <vector>
+
+#include "plugin.h"
+
+struct TweakActivityNotebook {
+  GtkNotebook *notebook = nullptr;
+  std::vector<gulong> handlers;
+};
+
+// Adds the class `xitweaks-activity` to sidebar and message window tab
+// labels whose content changed while another page was shown.  Each page
+// has one handler on its content, unblocked only while the page is hidden
+// and unmarked, so a build flooding the compiler tab costs one class change.
+class TweakActivity {
+ public:
+  TweakActivity() = default;
+
+  void update(gboolean enable);
+  void clear();
+
+ private:
+  void watch(GtkNotebook *notebook);
+
+  static void bind(GtkNotebook *notebook, GtkWidget *page, gboolean shown);
+  static void unbind(GtkWidget *page);
+
+  static void on_page_added(GtkNotebook *notebook, GtkWidget *page,
+                            guint page_num, gpointer user_data);
+  static void on_page_removed(GtkNotebook *notebook, GtkWidget *page,
+                              guint page_num, gpointer user_data);
+  static void on_switch_page(GtkNotebook *notebook, GtkWidget *page,
+                             guint page_num, gpointer user_data);
+
+  std::vector<TweakActivityNotebook> watched;
+};
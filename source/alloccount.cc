@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// Allocation counter for xi-tweaks-lifecycle --allocs, loaded with
+// LD_PRELOAD.
+//
+// Counts malloc(), calloc(), realloc(), and the aligned allocators called
+// on a thread while counting is switched on for it.  g_malloc() ends up in
+// malloc(), and so does g_slice_alloc() since GLib 2.76 or with
+// G_SLICE=always-malloc.  Needs glibc, which exports __libc_malloc() and
+// friends, so nothing has to be looked up with dlsym().
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+extern "C" {
+
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t n, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+
+static thread_local bool counting __attribute__((tls_model("initial-exec")));
+static uint64_t count = 0;
+
+static inline void note() {
+  if (counting) {
+    count++;
+  }
+}
+
+// called by the harness on the thread it measures
+void xitweaks_alloc_counting(int enable) { counting = enable != 0; }
+
+uint64_t xitweaks_alloc_count() { return count; }
+
+void *malloc(size_t size) {
+  note();
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size) {
+  note();
+  return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+  note();
+  return __libc_realloc(ptr, size);
+}
+
+void *memalign(size_t alignment, size_t size) {
+  note();
+  return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+  note();
+  return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **out, size_t alignment, size_t size) {
+  if (alignment % sizeof(void *) != 0 ||
+      (alignment & (alignment - 1)) != 0) {
+    return EINVAL;
+  }
+
+  note();
+  void *ptr = __libc_memalign(alignment, size);
+  if (ptr == nullptr) {
+    return ENOMEM;
+  }
+  *out = ptr;
+  return 0;
+}
+
+}  // extern "C"
@@ -0,0 +1,302 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "compacttabs.h"
+
+#include "notebooks.h"
+
+#define TWEAKS_COMPACT_SPACING 4
+
+// Global Variables
+TweakCompactTabs compacttabs;
+
+// what one drawing area stands in for
+struct TweakCompactTab {
+  GtkWidget *widget = nullptr;
+  GtkWidget *original = nullptr;  // referenced while swapped out
+  GtkWidget *label = nullptr;
+  GtkWidget *image = nullptr;  // file type icon, if Geany shows one
+
+  gulong label_handler = 0;
+  gulong name_handler = 0;
+  gulong tooltip_handler = 0;
+  gulong image_handler = 0;
+
+  PangoLayout *layout = nullptr;
+  GdkPixbuf *icon = nullptr;
+};
+
+static GQuark compact_quark() {
+  static GQuark quark = g_quark_from_static_string("xitweaks-compact-tab");
+  return quark;
+}
+
+// the first widget of a type, leaving out the close button
+static GtkWidget *find_child(GtkWidget *widget, GType type) {
+  if (G_TYPE_CHECK_INSTANCE_TYPE(widget, type)) {
+    return widget;
+  }
+  if (!GTK_IS_CONTAINER(widget) || GTK_IS_BUTTON(widget)) {
+    return nullptr;
+  }
+
+  GtkWidget *found = nullptr;
+  GList *children = gtk_container_get_children(GTK_CONTAINER(widget));
+  for (GList *item = children; item != nullptr && found == nullptr;
+       item = item->next) {
+    found = find_child(GTK_WIDGET(item->data), type);
+  }
+  g_list_free(children);
+
+  return found;
+}
+
+static GdkPixbuf *load_icon(GtkImage *image) {
+  gint width = 16, height = 16;
+
+  switch (gtk_image_get_storage_type(image)) {
+    case GTK_IMAGE_PIXBUF:
+      return GDK_PIXBUF(g_object_ref(gtk_image_get_pixbuf(image)));
+    case GTK_IMAGE_GICON: {
+      GIcon *gicon = nullptr;
+      GtkIconSize size = GTK_ICON_SIZE_MENU;
+      gtk_image_get_gicon(image, &gicon, &size);
+      gtk_icon_size_lookup(size, &width, &height);
+
+      GtkIconInfo *info = gtk_icon_theme_lookup_by_gicon(
+          gtk_icon_theme_get_default(), gicon, height,
+          GTK_ICON_LOOKUP_FORCE_SIZE);
+      if (info == nullptr) {
+        return nullptr;
+      }
+      GdkPixbuf *pixbuf = gtk_icon_info_load_icon(info, nullptr);
+      g_object_unref(info);
+      return pixbuf;
+    }
+    default:
+      return nullptr;
+  }
+}
+
+// Geany shows the modified and read-only states by naming the label.  The
+// drawing area's own name is the focus style, so the colour the label's
+// name gives it is drawn instead.
+static void compact_set_status_color(TweakCompactTab *tab) {
+  PangoAttrList *attrs = nullptr;
+
+  if (tab->label != nullptr &&
+      g_strcmp0(gtk_widget_get_name(tab->label),
+                G_OBJECT_TYPE_NAME(tab->label)) != 0) {
+    GtkStyleContext *context = gtk_widget_get_style_context(tab->label);
+    GdkRGBA color;
+    gtk_style_context_get_color(context, gtk_style_context_get_state(context),
+                                &color);
+
+    attrs = pango_attr_list_new();
+    pango_attr_list_insert(
+        attrs, pango_attr_foreground_new(guint16(color.red * 65535),
+                                         guint16(color.green * 65535),
+                                         guint16(color.blue * 65535)));
+    pango_attr_list_insert(
+        attrs, pango_attr_foreground_alpha_new(guint16(color.alpha * 65535)));
+  }
+
+  pango_layout_set_attributes(tab->layout, attrs);
+  if (attrs != nullptr) {
+    pango_attr_list_unref(attrs);
+  }
+}
+
+// Copies the label text, status colour, icon, and tooltip, and asks for
+// the size they need.  Called only when one of them changes.
+static void compact_refresh(TweakCompactTab *tab) {
+  char const *text =
+      tab->label != nullptr ? gtk_label_get_text(GTK_LABEL(tab->label)) : "";
+  pango_layout_set_text(tab->layout, text, -1);
+  compact_set_status_color(tab);
+
+  g_clear_object(&tab->icon);
+  if (tab->image != nullptr && gtk_widget_get_visible(tab->image)) {
+    tab->icon = load_icon(GTK_IMAGE(tab->image));
+  }
+
+  gchar *tooltip = gtk_widget_get_tooltip_text(tab->original);
+  gtk_widget_set_tooltip_text(tab->widget, tooltip);
+  g_free(tooltip);
+
+  gint width = 0, height = 0;
+  pango_layout_get_pixel_size(tab->layout, &width, &height);
+  if (tab->icon != nullptr) {
+    width += gdk_pixbuf_get_width(tab->icon) + TWEAKS_COMPACT_SPACING;
+    height = MAX(height, gdk_pixbuf_get_height(tab->icon));
+  }
+  gtk_widget_set_size_request(tab->widget, width, height);
+  gtk_widget_queue_draw(tab->widget);
+}
+
+static void on_compact_changed(TweakCompactTab *tab) { compact_refresh(tab); }
+
+// the font may have changed with the style
+static void on_compact_style_updated(GtkWidget *widget, TweakCompactTab *tab) {
+  pango_layout_context_changed(tab->layout);
+  compact_refresh(tab);
+}
+
+static gboolean on_compact_draw(GtkWidget *widget, cairo_t *cr,
+                                TweakCompactTab *tab) {
+  GtkStyleContext *context = gtk_widget_get_style_context(widget);
+  gint width = gtk_widget_get_allocated_width(widget);
+  gint height = gtk_widget_get_allocated_height(widget);
+
+  gtk_render_background(context, cr, 0, 0, width, height);
+  gtk_render_frame(context, cr, 0, 0, width, height);
+
+  gint x = 0;
+  if (tab->icon != nullptr) {
+    gtk_render_icon(context, cr, tab->icon, x,
+                    (height - gdk_pixbuf_get_height(tab->icon)) / 2.0);
+    x += gdk_pixbuf_get_width(tab->icon) + TWEAKS_COMPACT_SPACING;
+  }
+
+  gint text_width = 0, text_height = 0;
+  pango_layout_get_pixel_size(tab->layout, &text_width, &text_height);
+  gtk_render_layout(context, cr, x, (height - text_height) / 2.0,
+                    tab->layout);
+
+  return true;
+}
+
+// Geany's handlers on the original close the document on middle-click,
+// show the tab menu, hide the side panels on double-click, switch to the
+// last used tab on Ctrl+click, and return focus to the editor.  Presses
+// they leave go on to the notebook, which switches pages.
+static gboolean on_compact_button_press(GtkWidget *widget,
+                                        GdkEventButton *event,
+                                        TweakCompactTab *tab) {
+  gboolean handled = false;
+  g_signal_emit_by_name(tab->original, "button-press-event", event, &handled);
+  return handled;
+}
+
+static void compact_free(gpointer data) {
+  auto *tab = static_cast<TweakCompactTab *>(data);
+
+  if (tab->label != nullptr) {
+    g_signal_handler_disconnect(tab->label, tab->label_handler);
+    g_signal_handler_disconnect(tab->label, tab->name_handler);
+  }
+  if (tab->image != nullptr) {
+    g_signal_handler_disconnect(tab->image, tab->image_handler);
+  }
+  g_signal_handler_disconnect(tab->original, tab->tooltip_handler);
+  g_object_unref(tab->original);
+
+  g_clear_object(&tab->layout);
+  g_clear_object(&tab->icon);
+
+  delete tab;
+}
+
+// Functions
+
+void TweakCompactTabs::update(gboolean enable) {
+  if (enable && notebook == nullptr) {
+    notebook = GTK_NOTEBOOK(geany_data->main_widgets->notebook);
+    page_added_handler = g_signal_connect(
+        notebook, "page-added", G_CALLBACK(on_page_added), nullptr);
+
+    GList *pages = gtk_container_get_children(GTK_CONTAINER(notebook));
+    for (GList *item = pages; item != nullptr; item = item->next) {
+      swap(notebook, GTK_WIDGET(item->data));
+    }
+    g_list_free(pages);
+  } else if (!enable) {
+    clear();
+  }
+}
+
+void TweakCompactTabs::clear() {
+  if (notebook == nullptr) {
+    return;
+  }
+
+  g_signal_handler_disconnect(notebook, page_added_handler);
+  page_added_handler = 0;
+
+  GList *pages = gtk_container_get_children(GTK_CONTAINER(notebook));
+  for (GList *item = pages; item != nullptr; item = item->next) {
+    restore(notebook, GTK_WIDGET(item->data));
+  }
+  g_list_free(pages);
+
+  notebook = nullptr;
+}
+
+void TweakCompactTabs::swap(GtkNotebook *nb, GtkWidget *page) {
+  GtkWidget *original = gtk_notebook_get_tab_label(nb, page);
+  if (original == nullptr ||
+      g_object_get_qdata(G_OBJECT(original), compact_quark()) != nullptr) {
+    return;
+  }
+
+  auto *tab = new TweakCompactTab();
+  tab->original = GTK_WIDGET(g_object_ref(original));
+  tab->label = find_child(original, GTK_TYPE_LABEL);
+  tab->image = find_child(original, GTK_TYPE_IMAGE);
+
+  tab->widget = gtk_drawing_area_new();
+  tab->layout = gtk_widget_create_pango_layout(tab->widget, nullptr);
+  gtk_widget_add_events(tab->widget, GDK_BUTTON_PRESS_MASK);
+  gtk_style_context_add_class(gtk_widget_get_style_context(tab->widget),
+                              "xitweaks-compact-tab");
+
+  g_signal_connect(tab->widget, "draw", G_CALLBACK(on_compact_draw), tab);
+  g_signal_connect(tab->widget, "button-press-event",
+                   G_CALLBACK(on_compact_button_press), tab);
+  g_signal_connect(tab->widget, "style-updated",
+                   G_CALLBACK(on_compact_style_updated), tab);
+
+  if (tab->label != nullptr) {
+    tab->label_handler = g_signal_connect_swapped(
+        tab->label, "notify::label", G_CALLBACK(on_compact_changed), tab);
+    tab->name_handler = g_signal_connect_swapped(
+        tab->label, "notify::name", G_CALLBACK(on_compact_changed), tab);
+  }
+  if (tab->image != nullptr) {
+    tab->image_handler = g_signal_connect_swapped(
+        tab->image, "notify", G_CALLBACK(on_compact_changed), tab);
+  }
+  tab->tooltip_handler = g_signal_connect_swapped(
+      original, "notify::tooltip-text", G_CALLBACK(on_compact_changed), tab);
+
+  g_object_set_qdata_full(G_OBJECT(tab->widget), compact_quark(), tab,
+                          compact_free);
+
+  compact_refresh(tab);
+  gtk_widget_show(tab->widget);
+  gtk_notebook_set_tab_label(nb, page, tab->widget);
+
+  notebooks.set_tab_label(notebooks.find(nb), page, tab->widget);
+}
+
+// The drawing area, and with it the reference to the original, goes away
+// when the original is put back.
+void TweakCompactTabs::restore(GtkNotebook *nb, GtkWidget *page) {
+  GtkWidget *widget = gtk_notebook_get_tab_label(nb, page);
+  auto *tab = widget != nullptr
+                  ? static_cast<TweakCompactTab *>(
+                        g_object_get_qdata(G_OBJECT(widget), compact_quark()))
+                  : nullptr;
+  if (tab == nullptr) {
+    return;
+  }
+
+  GtkWidget *original = tab->original;
+  gtk_notebook_set_tab_label(nb, page, original);
+
+  notebooks.set_tab_label(notebooks.find(nb), page, original);
+}
+
+void TweakCompactTabs::on_page_added(GtkNotebook *notebook, GtkWidget *page,
+                                     guint page_num, gpointer user_data) {
+  swap(notebook, page);
+}
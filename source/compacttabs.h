@@ -0,0 +1,29 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "plugin.h"
+
+// Replaces each editor tab label, an event box holding a box, a label, and
+// a close button with its image, by one drawing area that renders the
+// icon and text.  The original label is kept and still updated by Geany;
+// its text, status colour, icon, and tooltip are copied when they change,
+// and button presses are passed on to it.  The replacement has the class
+// `xitweaks-compact-tab` and takes the focus and document state styles.
+class TweakCompactTabs {
+ public:
+  TweakCompactTabs() = default;
+
+  void update(gboolean enable);
+  void clear();
+
+ private:
+  static void swap(GtkNotebook *notebook, GtkWidget *page);
+  static void restore(GtkNotebook *notebook, GtkWidget *page);
+
+  static void on_page_added(GtkNotebook *notebook, GtkWidget *page,
+                            guint page_num, gpointer user_data);
+
+  GtkNotebook *notebook = nullptr;
+  gulong page_added_handler = 0;
+};
@@ -0,0 +1,153 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "counters.h"
+
+#include "auxiliary.h"
+#include "quality.h"
+#include "scheduler.h"
+
+// Global Variables
+TweakCounters counters;
+
+// Functions
+
+void TweakCounters::reset() {
+  for (guint64 &count : signals) {
+    count = 0;
+  }
+  for (gint64 &us : signal_us) {
+    us = 0;
+  }
+  handlers_connected = 0;
+  editor_notify = 0;
+  activity_marks = 0;
+
+  passes_requested = 0;
+  passes_coalesced = 0;
+  passes_deferred = 0;
+  bulk_loads = 0;
+  passes_inactive = 0;
+  passes = 0;
+  pages_visited = 0;
+  set_name_calls = 0;
+
+  find_focus_calls = 0;
+  find_focus_depth = 0;
+  find_focus_max_depth = 0;
+
+  for (guint64 &count : pass_histogram) {
+    count = 0;
+  }
+  pass_total_us = 0;
+  pass_max_us = 0;
+
+  reset_time = g_get_monotonic_time();
+}
+
+void TweakCounters::add_pass_duration(gint64 duration_us) {
+  int bucket = 0;
+  while (bucket < TWEAKS_HISTOGRAM_BUCKETS - 1 &&
+         duration_us >= (gint64(2) << bucket)) {
+    bucket++;
+  }
+
+  passes++;
+  pass_histogram[bucket]++;
+  pass_total_us += duration_us;
+  if (duration_us > pass_max_us) {
+    pass_max_us = duration_us;
+  }
+}
+
+std::string TweakCounters::format() const {
+  GString *out = g_string_new(nullptr);
+  gint64 elapsed = g_get_monotonic_time() - reset_time;
+
+  g_string_append_printf(out, "Collected over %.1f s\n\n", elapsed / 1e6);
+
+  g_string_append(out, "Signals\n");
+  for (int i = 0; i < TWEAKS_SIGNAL_COUNT; i++) {
+    g_string_append_printf(
+        out, "  %-24s %12llu %7.1f us\n",
+        trace_signal_name(TweakSignalKind(i)), (unsigned long long)signals[i],
+        signals[i] ? double(signal_us[i]) / double(signals[i]) : 0.0);
+  }
+  g_string_append_printf(out, "  %-24s %12llu\n", "editor-notify",
+                         (unsigned long long)editor_notify);
+  g_string_append_printf(out, "  %-24s %12llu\n", "handlers connected",
+                         (unsigned long long)handlers_connected);
+  g_string_append_printf(out, "  %-24s %12llu\n", "activity marks",
+                         (unsigned long long)activity_marks);
+
+  g_string_append(out, "\nHighlight passes\n");
+  g_string_append_printf(out, "  %-24s %12llu\n", "requested",
+                         (unsigned long long)passes_requested);
+  g_string_append_printf(out, "  %-24s %12llu\n", "coalesced",
+                         (unsigned long long)passes_coalesced);
+  g_string_append_printf(out, "  %-24s %12llu\n", "deferred by bulk load",
+                         (unsigned long long)passes_deferred);
+  g_string_append_printf(out, "  %-24s %12llu\n", "bulk loads",
+                         (unsigned long long)bulk_loads);
+  g_string_append_printf(out, "  %-24s %12llu\n", "deferred while inactive",
+                         (unsigned long long)passes_inactive);
+  g_string_append_printf(out, "  %-24s %12llu\n", "run",
+                         (unsigned long long)passes);
+  g_string_append_printf(out, "  %-24s %12llu\n", "pages visited",
+                         (unsigned long long)pages_visited);
+  g_string_append_printf(out, "  %-24s %12llu\n", "gtk_widget_set_name",
+                         (unsigned long long)set_name_calls);
+
+  g_string_append(out, "\nfind_focus_widget\n");
+  g_string_append_printf(out, "  %-24s %12llu\n", "calls",
+                         (unsigned long long)find_focus_calls);
+  g_string_append_printf(out, "  %-24s %12u\n", "max recursion depth",
+                         find_focus_max_depth);
+
+  g_string_append(out, "\nPass duration\n");
+  g_string_append_printf(
+      out, "  %-24s %12.1f us\n", "mean",
+      passes ? double(pass_total_us) / double(passes) : 0.0);
+  g_string_append_printf(out, "  %-24s %12lld us\n", "max",
+                         (long long)pass_max_us);
+  for (int i = 0; i < TWEAKS_HISTOGRAM_BUCKETS; i++) {
+    if (pass_histogram[i] != 0) {
+      g_string_append_printf(out, "  < %-10lld us %22llu\n",
+                             (long long)(gint64(2) << i),
+                             (unsigned long long)pass_histogram[i]);
+    }
+  }
+
+  g_string_append(out, "\nAdaptive quality\n");
+  g_string_append_printf(out, "  %-24s %12s\n", "level",
+                         TweakQuality::level_name(quality.get_level()));
+  g_string_append_printf(out, "  %-24s %9lld us\n", "budget",
+                         (long long)quality.get_budget_us());
+  g_string_append_printf(out, "  %-24s %12llu\n", "steps down",
+                         (unsigned long long)quality.get_steps_down());
+  g_string_append_printf(out, "  %-24s %12llu\n", "steps up",
+                         (unsigned long long)quality.get_steps_up());
+
+  TweakSchedulerStats const &sched = scheduler.get_stats();
+  g_string_append(out, "\nScheduler\n");
+  g_string_append_printf(out, "  %-24s %12llu\n", "tasks scheduled",
+                         (unsigned long long)sched.scheduled);
+  g_string_append_printf(out, "  %-24s %12llu\n", "tasks coalesced",
+                         (unsigned long long)sched.coalesced);
+  g_string_append_printf(out, "  %-24s %12.3f\n", "coalescing ratio",
+                         scheduler.get_coalesce_ratio());
+  g_string_append_printf(out, "  %-24s %12llu\n", "tasks executed",
+                         (unsigned long long)sched.executed);
+  g_string_append_printf(out, "  %-24s %12llu\n", "batches",
+                         (unsigned long long)sched.batches);
+  g_string_append_printf(out, "  %-24s %12llu\n", "batches over budget",
+                         (unsigned long long)sched.over_budget);
+  g_string_append_printf(out, "  %-24s %12u\n", "queue depth", sched.depth);
+  g_string_append_printf(out, "  %-24s %12u\n", "max queue depth",
+                         sched.max_depth);
+
+  return cstr_assign(g_string_free(out, false));
+}
+
+bool TweakCounters::export_to(std::string const &filename) const {
+  return file_set_contents(filename, format());
+}
@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <string>
+
+#include "plugin.h"
+#include "trace.h"
+
+// bucket i holds passes that took [2^i, 2^(i+1)) microseconds
+#define TWEAKS_HISTOGRAM_BUCKETS 24
+
+class TweakCounters {
+ public:
+  TweakCounters() { reset(); }
+
+  void reset();
+  void add_pass_duration(gint64 duration_us);
+
+  std::string format() const;
+  bool export_to(std::string const &filename) const;
+
+ public:
+  guint64 signals[TWEAKS_SIGNAL_COUNT];
+  gint64 signal_us[TWEAKS_SIGNAL_COUNT];  // time spent handling each
+  guint64 handlers_connected;
+  guint64 editor_notify;
+  guint64 activity_marks;
+
+  guint64 passes_requested;
+  guint64 passes_coalesced;
+  guint64 passes_deferred;  // requested while bulk loading
+  guint64 bulk_loads;
+  guint64 passes_inactive;  // requested while the window was inactive
+  guint64 passes;
+  guint64 pages_visited;
+  guint64 set_name_calls;
+
+  guint64 find_focus_calls;
+  guint find_focus_depth;
+  guint find_focus_max_depth;
+
+  guint64 pass_histogram[TWEAKS_HISTOGRAM_BUCKETS];
+  gint64 pass_total_us;
+  gint64 pass_max_us;
+
+  gint64 reset_time;
+};
@@ -0,0 +1,305 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "docstate.h"
+
+#include <stdlib.h>
+
+#include <unordered_map>
+
+#include "auxiliary.h"
+#include "notebooks.h"
+#include "prefs.h"
+#include "tabrules.h"
+
+// Global Variables
+TweakDocStates docstates;
+
+static GQuark docstate_quark() {
+  static GQuark quark = g_quark_from_static_string("xitweaks-docstate");
+  return quark;
+}
+
+static void docstate_free(gpointer data) {
+  delete static_cast<TweakDocState *>(data);
+}
+
+// the editor sits a few containers below its notebook page
+static GtkWidget *document_page(GeanyDocument *doc) {
+  GtkWidget *nb = geany_data->main_widgets->notebook;
+  GtkWidget *page = GTK_WIDGET(doc->editor->sci);
+
+  while (page != nullptr && gtk_widget_get_parent(page) != nb) {
+    page = gtk_widget_get_parent(page);
+  }
+  return page;
+}
+
+// Functions
+
+void TweakDocStates::update(GeanyDocument *doc) {
+  if (!is_active() || !DOC_VALID(doc) || notebooks.is_bulk_loading()) {
+    return;
+  }
+
+  TweakDocState *state = lookup(doc);
+  if (state != nullptr) {
+    refresh(state, doc, get_flags(doc));
+  }
+}
+
+// Scintilla reports save points before Geany updates doc->changed.
+void TweakDocStates::set_modified(GeanyDocument *doc, gboolean modified) {
+  if (!settings.doc_state_enabled || !DOC_VALID(doc) ||
+      notebooks.is_bulk_loading()) {
+    return;
+  }
+
+  TweakDocState *state = lookup(doc);
+  if (state != nullptr) {
+    guint flags = get_flags(doc) & ~TWEAKS_DOC_MODIFIED;
+    if (modified) {
+      flags |= TWEAKS_DOC_MODIFIED;
+    }
+    refresh(state, doc, flags);
+  }
+}
+
+void TweakDocStates::set_project(GeanyProject *project) {
+  project_dir.clear();
+  project_generation++;
+
+  if (project != nullptr && project->base_path != nullptr &&
+      project->base_path[0] != '\0') {
+    // base_path may be relative to the project file
+    std::string dir = cstr_assign(g_path_get_dirname(project->file_name));
+    project_dir = cstr_assign(
+        g_canonicalize_filename(project->base_path, dir.c_str()));
+
+    // doc->real_path has symlinks resolved, so the prefix needs them too
+    char *real_dir = realpath(project_dir.c_str(), nullptr);
+    if (real_dir != nullptr) {
+      project_dir = real_dir;
+      free(real_dir);
+    }
+    project_dir += G_DIR_SEPARATOR_S;
+  }
+
+  update_all();
+}
+
+// At unload, after clear_all(); the module stays loaded, and a project
+// closed meanwhile must not be matched against after reloading.
+void TweakDocStates::clear_project() {
+  project_dir.clear();
+  project_generation++;
+}
+
+void TweakDocStates::update_all() {
+  if (!is_active()) {
+    clear_all();
+    return;
+  }
+
+  // match pages to labels in one walk rather than one lookup per document
+  std::vector<TweakPage> pages;
+  notebook_collect_pages(GTK_NOTEBOOK(geany_data->main_widgets->notebook),
+                         pages);
+
+  std::unordered_map<GtkWidget *, GtkWidget *> labels;
+  labels.reserve(pages.size());
+  for (TweakPage const &page : pages) {
+    labels[page.page] = page.label;
+  }
+
+  guint i = 0;
+  foreach_document(i) {
+    GeanyDocument *doc = documents[i];
+    auto it = labels.find(document_page(doc));
+
+    TweakDocState *state =
+        lookup(doc, it != labels.end() ? it->second : nullptr);
+    if (state != nullptr) {
+      refresh(state, doc, get_flags(doc));
+    }
+  }
+}
+
+void TweakDocStates::clear_all() {
+  guint i = 0;
+  foreach_document(i) { remove(documents[i]); }
+}
+
+gboolean TweakDocStates::is_active() const {
+  return settings.doc_state_enabled || !tabrules.empty();
+}
+
+TweakDocState *TweakDocStates::lookup(GeanyDocument *doc, GtkWidget *label) {
+  GObject *sci = G_OBJECT(doc->editor->sci);
+
+  auto *state =
+      static_cast<TweakDocState *>(g_object_get_qdata(sci, docstate_quark()));
+  if (state != nullptr) {
+    return state;
+  }
+
+  // once per document; the label lives as long as the page
+  if (label == nullptr) {
+    GtkWidget *page = document_page(doc);
+    if (page == nullptr) {
+      return nullptr;
+    }
+    label = gtk_notebook_get_tab_label(
+        GTK_NOTEBOOK(geany_data->main_widgets->notebook), page);
+  }
+  if (label == nullptr) {
+    return nullptr;
+  }
+
+  state = new TweakDocState();
+  state->label = label;
+  g_object_set_qdata_full(sci, docstate_quark(), state, docstate_free);
+
+  return state;
+}
+
+void TweakDocStates::refresh(TweakDocState *state, GeanyDocument *doc,
+                             guint flags) {
+  gint filetype = -1;
+  if (settings.doc_state_enabled && doc->file_type != nullptr) {
+    filetype = doc->file_type->id;
+  }
+
+  apply(state, flags, filetype, get_rules(state, doc));
+}
+
+void TweakDocStates::apply(TweakDocState *state, guint flags, gint filetype,
+                           guint64 rules) {
+  static struct {
+    guint flag;
+    char const *name;
+  } const classes[] = {
+      {TWEAKS_DOC_MODIFIED, "xitweaks-doc-modified"},
+      {TWEAKS_DOC_READONLY, "xitweaks-doc-readonly"},
+      {TWEAKS_DOC_EXTERNAL, "xitweaks-doc-external"},
+  };
+
+  guint changed = state->flags ^ flags;
+  guint64 rules_changed = state->rules ^ rules;
+  if (changed == 0 && rules_changed == 0 && state->filetype == filetype) {
+    return;
+  }
+
+  GtkStyleContext *context = gtk_widget_get_style_context(state->label);
+
+  for (auto const &cls : classes) {
+    if (changed & cls.flag) {
+      if (flags & cls.flag) {
+        gtk_style_context_add_class(context, cls.name);
+      } else {
+        gtk_style_context_remove_class(context, cls.name);
+      }
+    }
+  }
+  state->flags = flags;
+
+  if (state->filetype != filetype) {
+    if (state->filetype >= 0) {
+      gtk_style_context_remove_class(context, filetype_class(state->filetype));
+    }
+    if (filetype >= 0) {
+      gtk_style_context_add_class(context, filetype_class(filetype));
+    }
+    state->filetype = filetype;
+  }
+
+  for (int bit = 0; rules_changed != 0; bit++, rules_changed >>= 1) {
+    if (rules_changed & 1) {
+      if (rules & (guint64(1) << bit)) {
+        gtk_style_context_add_class(context, tabrules.get_class(bit));
+      } else {
+        gtk_style_context_remove_class(context, tabrules.get_class(bit));
+      }
+    }
+  }
+  state->rules = rules;
+}
+
+void TweakDocStates::remove(GeanyDocument *doc) {
+  GObject *sci = G_OBJECT(doc->editor->sci);
+
+  auto *state =
+      static_cast<TweakDocState *>(g_object_get_qdata(sci, docstate_quark()));
+  if (state != nullptr) {
+    apply(state, 0, -1, 0);
+    g_object_set_qdata(sci, docstate_quark(), nullptr);
+  }
+}
+
+guint TweakDocStates::get_flags(GeanyDocument *doc) const {
+  guint flags = 0;
+
+  if (!settings.doc_state_enabled) {
+    return flags;
+  }
+
+  if (doc->changed) {
+    flags |= TWEAKS_DOC_MODIFIED;
+  }
+  if (doc->readonly) {
+    flags |= TWEAKS_DOC_READONLY;
+  }
+  if (!project_dir.empty() && doc->real_path != nullptr &&
+      !g_str_has_prefix(doc->real_path, project_dir.c_str())) {
+    flags |= TWEAKS_DOC_EXTERNAL;
+  }
+
+  return flags;
+}
+
+guint64 TweakDocStates::get_rules(TweakDocState *state,
+                                  GeanyDocument *doc) const {
+  char const *path = doc->real_path != nullptr ? doc->real_path : "";
+
+  if (state->rules_generation == tabrules.get_generation() &&
+      state->project_generation == project_generation && state->path == path) {
+    return state->rules;
+  }
+  state->rules_generation = tabrules.get_generation();
+  state->project_generation = project_generation;
+  state->path = path;
+
+  char const *rel_path = nullptr;
+  if (!project_dir.empty() && g_str_has_prefix(path, project_dir.c_str())) {
+    rel_path = path + project_dir.size();
+  }
+
+  return tabrules.match(doc->real_path, rel_path);
+}
+
+// Class names are built once per filetype: "C++" becomes
+// "xitweaks-filetype-cpp" and "C#" becomes "xitweaks-filetype-csharp".
+char const *TweakDocStates::filetype_class(gint filetype) {
+  if (guint(filetype) >= filetype_classes.size()) {
+    filetype_classes.resize(filetype + 1);
+  }
+
+  std::string &cls = filetype_classes[filetype];
+  if (cls.empty()) {
+    GeanyFiletype *ft = filetypes_index(filetype);
+
+    cls = "xitweaks-filetype-";
+    for (char const *c = ft != nullptr ? ft->name : "none"; *c != '\0'; c++) {
+      if (g_ascii_isalnum(*c)) {
+        cls += g_ascii_tolower(*c);
+      } else if (*c == '+') {
+        cls += 'p';
+      } else if (*c == '#') {
+        cls += "sharp";
+      } else {
+        cls += '-';
+      }
+    }
+  }
+
+  return cls.c_str();
+}
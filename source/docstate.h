@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "plugin.h"
+
+enum TweakDocFlags {
+  TWEAKS_DOC_MODIFIED = 1 << 0,  // unsaved changes
+  TWEAKS_DOC_READONLY = 1 << 1,
+  TWEAKS_DOC_EXTERNAL = 1 << 2,  // file outside the open project
+};
+
+// classes last applied to a document's tab label
+struct TweakDocState {
+  GtkWidget *label = nullptr;
+  guint flags = 0;
+  gint filetype = -1;
+
+  // tab style rules, matched again only when the path or rules change
+  guint64 rules = 0;
+  guint rules_generation = 0;
+  guint project_generation = 0;
+  std::string path;
+};
+
+// Styles editor tab labels by document state with CSS classes.  Each event
+// updates only the document it concerns, and only the classes that differ.
+class TweakDocStates {
+ public:
+  TweakDocStates() = default;
+
+  void update(GeanyDocument *doc);
+  void set_modified(GeanyDocument *doc, gboolean modified);
+  void set_project(GeanyProject *project);
+  void clear_project();
+
+  void update_all();
+  void clear_all();
+
+ private:
+  gboolean is_active() const;
+  TweakDocState *lookup(GeanyDocument *doc, GtkWidget *label = nullptr);
+  void refresh(TweakDocState *state, GeanyDocument *doc, guint flags);
+  void apply(TweakDocState *state, guint flags, gint filetype, guint64 rules);
+  void remove(GeanyDocument *doc);
+
+  guint get_flags(GeanyDocument *doc) const;
+  guint64 get_rules(TweakDocState *state, GeanyDocument *doc) const;
+  char const *filetype_class(gint filetype);
+
+  std::string project_dir;
+  guint project_generation = 0;
+  std::vector<std::string> filetype_classes;
+};
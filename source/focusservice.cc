@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "focusservice.h"
+
+#include "notebooks.h"
+
+struct _TweaksFocusService {
+  GObject parent_instance;
+
+  // last emitted; the pointers are compared, never dereferenced
+  gint kind;
+  gpointer page;
+  gpointer widget;
+  gboolean forced;  // emit the next update even if unchanged
+};
+
+enum {
+  SIGNAL_FOCUS_CHANGED,
+  SIGNAL_REFRESH,
+  SIGNAL_COUNT,
+};
+
+static guint signals[SIGNAL_COUNT];
+
+static_assert(int(XITWEAKS_FOCUS_SIDEBAR) == int(TWEAKS_NOTEBOOK_SIDEBAR) &&
+                  int(XITWEAKS_FOCUS_MSGWIN) == int(TWEAKS_NOTEBOOK_MSGWIN) &&
+                  int(XITWEAKS_FOCUS_EDITOR) == int(TWEAKS_NOTEBOOK_EDITOR) &&
+                  int(XITWEAKS_FOCUS_OTHER) == int(TWEAKS_NOTEBOOK_OTHER),
+              "XiTweaksFocusKind does not match TweakNotebookKind");
+
+G_DEFINE_TYPE(TweaksFocusService, tweaks_focus_service, G_TYPE_OBJECT)
+
+// Functions
+
+static void tweaks_focus_service_refresh(TweaksFocusService *self) {
+  self->forced = true;
+  focus_service_refresh();
+}
+
+static void tweaks_focus_service_class_init(TweaksFocusServiceClass *klass) {
+  GType type = G_TYPE_FROM_CLASS(klass);
+
+  signals[SIGNAL_FOCUS_CHANGED] =
+      g_signal_new("focus-changed", type, G_SIGNAL_RUN_LAST, 0, nullptr,
+                   nullptr, nullptr, G_TYPE_NONE, 3, G_TYPE_INT,
+                   GTK_TYPE_WIDGET, GTK_TYPE_WIDGET);
+
+  signals[SIGNAL_REFRESH] = g_signal_new_class_handler(
+      "refresh", type, GSignalFlags(G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION),
+      G_CALLBACK(tweaks_focus_service_refresh), nullptr, nullptr, nullptr,
+      G_TYPE_NONE, 0);
+}
+
+static void tweaks_focus_service_init(TweaksFocusService *self) {
+  self->kind = XITWEAKS_FOCUS_NONE;
+}
+
+TweaksFocusService *tweaks_focus_service_new() {
+  return TWEAKS_FOCUS_SERVICE(
+      g_object_new(TWEAKS_TYPE_FOCUS_SERVICE, nullptr));
+}
+
+gboolean tweaks_focus_service_is_listening(TweaksFocusService *self) {
+  return self != nullptr &&
+         g_signal_has_handler_pending(self, signals[SIGNAL_FOCUS_CHANGED], 0,
+                                      true);
+}
+
+// Called after every highlight pass; emits only when something changed.
+void tweaks_focus_service_update(TweaksFocusService *self, gint kind,
+                                 GtkWidget *page, GtkWidget *widget) {
+  if (self == nullptr) {
+    return;
+  }
+  if (!self->forced && self->kind == kind && self->page == page &&
+      self->widget == widget) {
+    return;
+  }
+
+  self->kind = kind;
+  self->page = page;
+  self->widget = widget;
+  self->forced = false;
+
+  if (tweaks_focus_service_is_listening(self)) {
+    g_signal_emit(self, signals[SIGNAL_FOCUS_CHANGED], 0, kind, page, widget);
+  }
+}
@@ -0,0 +1,20 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "plugin.h"
+#include "xitweaks-focus.h"
+
+G_BEGIN_DECLS
+
+#define TWEAKS_TYPE_FOCUS_SERVICE (tweaks_focus_service_get_type())
+G_DECLARE_FINAL_TYPE(TweaksFocusService, tweaks_focus_service, TWEAKS,
+                     FOCUS_SERVICE, GObject)
+
+TweaksFocusService *tweaks_focus_service_new();
+
+gboolean tweaks_focus_service_is_listening(TweaksFocusService *self);
+void tweaks_focus_service_update(TweaksFocusService *self, gint kind,
+                                 GtkWidget *page, GtkWidget *widget);
+
+G_END_DECLS
@@ -0,0 +1,397 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// Key-to-paint latency of the focus keybinding in a real Geany.
+//
+// usage: xi-tweaks-key-to-paint [--presses n] plugin.so [documents...]
+//
+// For each document count (by default 1, 100, and 1000), Geany is started
+// with a scratch config, the plugin, and that many files open.  The focus
+// keybinding is bound to Ctrl+Shift+F12 and pressed through XTest.  The
+// plugin, run with XITWEAKS_LATENCY_FILE, appends the time of the frame
+// that shows the restyled tab, so the latency covers X, GDK, Geany's
+// keybinding dispatch, the highlight pass, and the paint.  Both sides use
+// the monotonic clock.  Needs a display and no window manager, so run it
+// under xvfb-run.  Exits with 1 if a run produced no samples.
+
+#include <X11/Xatom.h>
+#include <X11/Xlib.h>
+#include <X11/extensions/XTest.h>
+#include <X11/keysym.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+
+#include <algorithm>
+#include <vector>
+
+#define KEY_NAME "xitweaks_switch_focus_editor_sidebar_msgwin"
+#define KEY_ACCEL "<Primary><Shift>F12"
+
+#define READY_TIMEOUT_US (120 * G_USEC_PER_SEC)
+#define PRESS_TIMEOUT_US (2 * G_USEC_PER_SEC)
+#define WARMUP_PRESSES 10
+
+struct KeyToPaintRun {
+  int documents = 0;
+  int missed = 0;
+  std::vector<gint64> total_us;  // key injected to frame painted
+  std::vector<gint64> geany_us;  // keybinding callback to frame painted
+};
+
+/* ********************
+ * Files
+ */
+
+static void write_file(char const *dir, char const *name,
+                       char const *contents) {
+  g_mkdir_with_parents(dir, 0755);
+  gchar *filename = g_build_filename(dir, name, nullptr);
+  g_file_set_contents(filename, contents, -1, nullptr);
+  g_free(filename);
+}
+
+static void write_config(char const *config_dn, char const *plugin_fn) {
+  gchar *contents = g_strdup_printf(
+      "[geany]\n"
+      "sidebar_visible=true\n"
+      "msgwindow_visible=true\n"
+      "[plugins]\n"
+      "load_plugins=true\n"
+      "active_plugins=%s;\n",
+      plugin_fn);
+  write_file(config_dn, "geany.conf", contents);
+  g_free(contents);
+
+  write_file(config_dn, "keybindings.conf",
+             "[Bindings]\n" KEY_NAME "=" KEY_ACCEL "\n");
+
+  gchar *plugin_dn =
+      g_build_filename(config_dn, "plugins", "xitweaks", nullptr);
+  write_file(plugin_dn, "xitweaks.conf",
+             "[tweaks]\n"
+             "sidebar_focus_enabled=true\n"
+             "notebook_focus_enabled=true\n");
+  g_free(plugin_dn);
+}
+
+static void remove_tree(char const *path) {
+  if (g_file_test(path, G_FILE_TEST_IS_DIR)) {
+    GDir *dir = g_dir_open(path, 0, nullptr);
+    char const *name;
+    while (dir != nullptr && (name = g_dir_read_name(dir)) != nullptr) {
+      gchar *child = g_build_filename(path, name, nullptr);
+      remove_tree(child);
+      g_free(child);
+    }
+    if (dir != nullptr) {
+      g_dir_close(dir);
+    }
+  }
+  g_remove(path);
+}
+
+// Reads the lines appended since the last call.  Only whole lines are
+// consumed, so a line being written is picked up next time.
+static void read_samples(char const *filename, long &offset,
+                         std::vector<gint64> &key_us,
+                         std::vector<gint64> &paint_us) {
+  FILE *fp = fopen(filename, "r");
+  if (fp == nullptr) {
+    return;
+  }
+
+  char line[128];
+  fseek(fp, offset, SEEK_SET);
+  while (fgets(line, sizeof(line), fp) != nullptr &&
+         strchr(line, '\n') != nullptr) {
+    long long key, pass, paint;
+    if (sscanf(line, "%lld %lld %lld", &key, &pass, &paint) == 3) {
+      key_us.push_back(key);
+      paint_us.push_back(paint);
+    }
+    offset = ftell(fp);
+  }
+  fclose(fp);
+}
+
+/* ********************
+ * X11
+ */
+
+static gboolean window_has_pid(Display *display, Window window, int pid) {
+  static Atom net_wm_pid = XInternAtom(display, "_NET_WM_PID", false);
+
+  Atom type;
+  int format;
+  unsigned long count, after;
+  unsigned char *data = nullptr;
+  gboolean found = false;
+
+  if (XGetWindowProperty(display, window, net_wm_pid, 0, 1, false,
+                         XA_CARDINAL, &type, &format, &count, &after,
+                         &data) == Success &&
+      data != nullptr) {
+    found = count == 1 && int(*(unsigned long *)data) == pid;
+  }
+  if (data != nullptr) {
+    XFree(data);
+  }
+  return found;
+}
+
+// the largest mapped top-level window of the process
+static Window find_main_window(Display *display, int pid) {
+  Window root, parent, *children = nullptr;
+  unsigned int count = 0;
+  Window found = None;
+  int found_area = 0;
+
+  if (!XQueryTree(display, DefaultRootWindow(display), &root, &parent,
+                  &children, &count)) {
+    return None;
+  }
+
+  for (unsigned int i = 0; i < count; i++) {
+    XWindowAttributes attrs;
+    if (XGetWindowAttributes(display, children[i], &attrs) &&
+        attrs.map_state == IsViewable &&
+        attrs.width * attrs.height > found_area &&
+        window_has_pid(display, children[i], pid)) {
+      found = children[i];
+      found_area = attrs.width * attrs.height;
+    }
+  }
+  if (children != nullptr) {
+    XFree(children);
+  }
+  return found;
+}
+
+// Returns the time the key went out.  The modifiers are flushed first so
+// they are not part of the measurement.
+static gint64 press_keybinding(Display *display) {
+  KeyCode control = XKeysymToKeycode(display, XK_Control_L);
+  KeyCode shift = XKeysymToKeycode(display, XK_Shift_L);
+  KeyCode key = XKeysymToKeycode(display, XK_F12);
+
+  XTestFakeKeyEvent(display, control, true, CurrentTime);
+  XTestFakeKeyEvent(display, shift, true, CurrentTime);
+  XSync(display, false);
+
+  gint64 sent = g_get_monotonic_time();
+  XTestFakeKeyEvent(display, key, true, CurrentTime);
+  XFlush(display);
+
+  XTestFakeKeyEvent(display, key, false, CurrentTime);
+  XTestFakeKeyEvent(display, shift, false, CurrentTime);
+  XTestFakeKeyEvent(display, control, false, CurrentTime);
+  XSync(display, false);
+
+  return sent;
+}
+
+/* ********************
+ * Runs
+ */
+
+static gint64 percentile(std::vector<gint64> const &sorted, double p) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  size_t index = size_t(p * (sorted.size() - 1) + 0.5);
+  return sorted[std::min(index, sorted.size() - 1)];
+}
+
+// Presses the keybinding and waits for the frame.  Geany may still be
+// loading documents, in which case the press is counted as missed.
+static bool measure_press(Display *display, char const *latency_fn,
+                          long &offset, gint64 timeout_us,
+                          KeyToPaintRun *run) {
+  gint64 sent = press_keybinding(display);
+  gint64 deadline = sent + timeout_us;
+
+  while (g_get_monotonic_time() < deadline) {
+    std::vector<gint64> key_us, paint_us;
+    read_samples(latency_fn, offset, key_us, paint_us);
+
+    for (size_t i = 0; i < paint_us.size(); i++) {
+      if (key_us[i] >= sent) {
+        if (run != nullptr) {
+          run->total_us.push_back(paint_us[i] - sent);
+          run->geany_us.push_back(paint_us[i] - key_us[i]);
+        }
+        // let the frame after it go by
+        g_usleep(20000);
+        return true;
+      }
+    }
+    g_usleep(500);
+  }
+
+  if (run != nullptr) {
+    run->missed++;
+  }
+  return false;
+}
+
+static bool measure(Display *display, char const *plugin_fn, int documents,
+                    int presses, KeyToPaintRun &run) {
+  run.documents = documents;
+
+  gchar *tmp_dn = g_dir_make_tmp("xi-tweaks-key-to-paint-XXXXXX", nullptr);
+  if (tmp_dn == nullptr) {
+    fprintf(stderr, "cannot create a temporary directory\n");
+    return false;
+  }
+  gchar *config_dn = g_build_filename(tmp_dn, "config", nullptr);
+  gchar *latency_fn = g_build_filename(tmp_dn, "latency.txt", nullptr);
+  write_config(config_dn, plugin_fn);
+
+  GPtrArray *argv = g_ptr_array_new_with_free_func(g_free);
+  g_ptr_array_add(argv, g_strdup("geany"));
+  g_ptr_array_add(argv, g_strdup("--new-instance"));
+  g_ptr_array_add(argv, g_strdup("--no-session"));
+  g_ptr_array_add(argv, g_strdup_printf("--config=%s", config_dn));
+  for (int i = 0; i < documents; i++) {
+    gchar *name = g_strdup_printf("doc-%04d.c", i);
+    write_file(tmp_dn, name, "int main() {\n  return 0;\n}\n");
+    g_ptr_array_add(argv, g_build_filename(tmp_dn, name, nullptr));
+    g_free(name);
+  }
+  g_ptr_array_add(argv, nullptr);
+
+  gchar **envp = g_environ_setenv(g_get_environ(), "XITWEAKS_LATENCY_FILE",
+                                  latency_fn, true);
+
+  GPid pid = 0;
+  GError *error = nullptr;
+  bool ok = g_spawn_async(
+      nullptr, (gchar **)argv->pdata, envp,
+      GSpawnFlags(G_SPAWN_SEARCH_PATH | G_SPAWN_DO_NOT_REAP_CHILD |
+                  G_SPAWN_STDOUT_TO_DEV_NULL | G_SPAWN_STDERR_TO_DEV_NULL),
+      nullptr, nullptr, &pid, &error);
+  if (!ok) {
+    fprintf(stderr, "%s\n", error->message);
+    g_error_free(error);
+  }
+
+  // the window maps before the documents are loaded; the first press that
+  // gets painted shows that Geany is idle
+  Window window = None;
+  gint64 ready_deadline = g_get_monotonic_time() + READY_TIMEOUT_US;
+  long offset = 0;
+  bool ready = false;
+
+  while (ok && !ready && g_get_monotonic_time() < ready_deadline) {
+    if (window == None) {
+      window = find_main_window(display, pid);
+      if (window == None) {
+        g_usleep(100000);
+        continue;
+      }
+      XSetInputFocus(display, window, RevertToParent, CurrentTime);
+      XSync(display, false);
+    }
+    ready = measure_press(display, latency_fn, offset, PRESS_TIMEOUT_US,
+                          nullptr);
+  }
+
+  if (ok && !ready) {
+    fprintf(stderr, "%d documents: no frame painted after the keybinding\n",
+            documents);
+  }
+  for (int i = 0; ready && i < WARMUP_PRESSES; i++) {
+    measure_press(display, latency_fn, offset, PRESS_TIMEOUT_US, nullptr);
+  }
+  for (int i = 0; ready && i < presses; i++) {
+    measure_press(display, latency_fn, offset, PRESS_TIMEOUT_US, &run);
+  }
+
+  if (pid != 0) {
+    kill(pid, SIGTERM);
+    waitpid(pid, nullptr, 0);
+    g_spawn_close_pid(pid);
+  }
+
+  g_strfreev(envp);
+  g_ptr_array_free(argv, true);
+  remove_tree(tmp_dn);
+  g_free(latency_fn);
+  g_free(config_dn);
+  g_free(tmp_dn);
+
+  return !run.total_us.empty();
+}
+
+static void print_run(KeyToPaintRun &run) {
+  std::sort(run.total_us.begin(), run.total_us.end());
+  std::sort(run.geany_us.begin(), run.geany_us.end());
+
+  printf("%9d %7zu %6d %8lld %8lld %8lld %8lld %8lld\n", run.documents,
+         run.total_us.size(), run.missed,
+         (long long)percentile(run.total_us, 0.50),
+         (long long)percentile(run.total_us, 0.95),
+         (long long)percentile(run.total_us, 0.99),
+         (long long)percentile(run.total_us, 1.0),
+         (long long)percentile(run.geany_us, 0.50));
+}
+
+int main(int argc, char **argv) {
+  int presses = 200;
+  int arg = 1;
+
+  if (argc > 2 && strcmp(argv[1], "--presses") == 0) {
+    presses = std::max(atoi(argv[2]), 1);
+    arg = 3;
+  }
+  if (arg >= argc) {
+    fprintf(stderr, "usage: %s [--presses n] plugin.so [documents...]\n",
+            argv[0]);
+    return 2;
+  }
+
+  gchar *plugin_fn = g_canonicalize_filename(argv[arg], nullptr);
+  std::vector<int> counts;
+  for (int i = arg + 1; i < argc; i++) {
+    counts.push_back(std::max(atoi(argv[i]), 1));
+  }
+  if (counts.empty()) {
+    counts = {1, 100, 1000};
+  }
+
+  Display *display = XOpenDisplay(nullptr);
+  int event_base, error_base, major, minor;
+  if (display == nullptr) {
+    fprintf(stderr, "cannot open display; run under xvfb-run\n");
+    return 2;
+  }
+  if (!XTestQueryExtension(display, &event_base, &error_base, &major,
+                           &minor)) {
+    fprintf(stderr, "the X server does not support XTest\n");
+    return 2;
+  }
+
+  int status = 0;
+  std::vector<KeyToPaintRun> runs(counts.size());
+  for (size_t i = 0; i < counts.size(); i++) {
+    if (!measure(display, plugin_fn, counts[i], presses, runs[i])) {
+      status = 1;
+    }
+  }
+
+  printf("key-to-paint latency in us over %d presses\n", presses);
+  printf("%9s %7s %6s %8s %8s %8s %8s %8s\n", "documents", "samples",
+         "missed", "p50", "p95", "p99", "max", "geany50");
+  for (KeyToPaintRun &run : runs) {
+    print_run(run);
+  }
+
+  XCloseDisplay(display);
+  g_free(plugin_fn);
+
+  return status;
+}
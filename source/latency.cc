@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "latency.h"
+
+// Global Variables
+TweakLatencyProbe latency;
+
+// Functions
+
+void TweakLatencyProbe::open(char const *filename) {
+  close();
+  if (filename != nullptr) {
+    file = fopen(filename, "w");
+  }
+}
+
+void TweakLatencyProbe::close() {
+  if (clock != nullptr) {
+    g_signal_handler_disconnect(clock, clock_handler);
+    g_object_unref(clock);
+    clock = nullptr;
+    clock_handler = 0;
+  }
+  if (file != nullptr) {
+    fclose(file);
+    file = nullptr;
+  }
+  key_us = 0;
+}
+
+void TweakLatencyProbe::key_pressed() {
+  if (file != nullptr) {
+    key_us = g_get_monotonic_time();
+  }
+}
+
+// The new names are drawn in the next frame.  The paint phase is requested
+// so the frame runs even if the stylesheet gives both names the same look.
+void TweakLatencyProbe::pass_done(GtkWidget *window, guint style_writes) {
+  if (key_us == 0 || style_writes == 0 || clock != nullptr) {
+    return;
+  }
+
+  GdkFrameClock *frame_clock = gtk_widget_get_frame_clock(window);
+  if (frame_clock == nullptr) {
+    key_us = 0;
+    return;
+  }
+
+  pass_us = g_get_monotonic_time();
+  clock = GDK_FRAME_CLOCK(g_object_ref(frame_clock));
+  clock_handler = g_signal_connect(clock, "after-paint",
+                                   G_CALLBACK(on_after_paint), this);
+  gdk_frame_clock_request_phase(clock, GDK_FRAME_CLOCK_PHASE_PAINT);
+}
+
+void TweakLatencyProbe::on_after_paint(GdkFrameClock *clock,
+                                       TweakLatencyProbe *self) {
+  fprintf(self->file, "%lld %lld %lld\n", (long long)self->key_us,
+          (long long)self->pass_us, (long long)g_get_monotonic_time());
+  fflush(self->file);
+
+  g_signal_handler_disconnect(self->clock, self->clock_handler);
+  g_object_unref(self->clock);
+  self->clock = nullptr;
+  self->clock_handler = 0;
+  self->key_us = 0;
+}
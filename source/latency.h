@@ -0,0 +1,29 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "plugin.h"
+
+// Timestamps the frame that shows the result of the focus keybinding, for
+// xi-tweaks-key-to-paint (source/keytopaint.cc).  Enabled by setting
+// XITWEAKS_LATENCY_FILE; each press that restyles a tab appends
+// "key pass paint" in monotonic microseconds.
+class TweakLatencyProbe {
+ public:
+  TweakLatencyProbe() = default;
+
+  void open(char const *filename);
+  void close();
+
+  void key_pressed();
+  void pass_done(GtkWidget *window, guint style_writes);
+
+ private:
+  static void on_after_paint(GdkFrameClock *clock, TweakLatencyProbe *self);
+
+  FILE *file = nullptr;
+  GdkFrameClock *clock = nullptr;
+  gulong clock_handler = 0;
+  gint64 key_us = 0;
+  gint64 pass_us = 0;
+};
@@ -0,0 +1,1571 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// Load and unload cycles of the plugin in a mock Geany.
+//
+// usage: xi-tweaks-lifecycle [--mode count] plugin.so [cycles]
+//
+// The host provides the parts of the Geany API the plugin uses, builds a
+// main window with sidebar, message window, and editor notebooks, and runs
+// plugin_init() and plugin_cleanup() in a loop.  It reports how long each
+// takes and what the cycles leave behind: GObjects (counted only with
+// GOBJECT_DEBUG=instance-count), signal handlers on the main window and
+// its notebooks, and main loop sources.  Needs a display, so run it under
+// xvfb-run.  Exits with 1 if anything was left behind.  Every other cycle
+// opens a project that turns compact tabs off and closes it only after
+// unloading, as Geany does with the plugin manager; the exit status is
+// also 1 if the project's settings still apply after loading again.
+//
+// With --soak, the plugin is loaded once while documents are opened and
+// closed, focus moves, and the config is reloaded for the given time.
+// RSS, live GObjects, and signal handlers are sampled every second, and
+// the exit status is 1 if any of them keeps growing.
+//
+// With --tabs, the editor gets the given number of tabs labeled the way
+// Geany labels them, and the time to restyle and lay out the tab strip is
+// compared between Geany's tab labels and compact ones.
+//
+// With --startup, the plugin is loaded before the main window is
+// realized, as at Geany startup, and the given number of documents is
+// added to the editor.  The time from geany-startup-complete until the
+// main loop is idle, and the passes run in it, are reported.
+//
+// With --inactive, the main window is deactivated and activated again the
+// given number of times while an editor has focus, with the focus-out
+// Scintilla reports when it loses focus.  Every other time, the config is
+// reloaded meanwhile.  The exit status is 1 if any tab or page was
+// restyled.  Then the preferences toggle for highlighting every notebook
+// is flipped while another window is active; the exit status is also 1
+// if that writes any style before the main window is active again, or if
+// the editor tab does not follow the toggle once it is.
+//
+// With --switcher, the given number of documents is opened and the quick
+// switcher is shown.  Queries are typed into it a character at a time,
+// and the time each keystroke takes to update the results is reported.
+//
+// With --allocs, the given number of focus events is replayed on the
+// notebooks while focus stays put, and the heap allocations made from the
+// signal through the highlight pass it schedules are counted.  Needs
+// xi-tweaks-alloc-count.so in LD_PRELOAD.  The exit status is 1 if any
+// event allocated.
+//
+// With --scheduler, the preferences are closed with unsaved changes,
+// which queues a low priority save, and a focus event queues a highlight
+// pass right after, the given number of times.  The exit status is 1 if
+// the save runs in the same dispatch as the pass instead of a later one
+// at its own priority.
+
+#include <glib/gstdio.h>
+#include <gmodule.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "geanyplugin.h"
+
+typedef gint (*VersionCheckFunc)(gint abi_version);
+typedef void (*SetInfoFunc)(PluginInfo *info);
+typedef void (*InitFunc)(GeanyData *data);
+typedef void (*CleanupFunc)();
+typedef GtkWidget *(*ConfigureFunc)(GtkDialog *dialog);
+typedef void (*StartupFunc)(GObject *object, gpointer user_data);
+typedef void (*ProjectOpenFunc)(GObject *object, GKeyFile *config,
+                                gpointer user_data);
+typedef gboolean (*EditorNotifyFunc)(GObject *object, GeanyEditor *editor,
+                                     SCNotification *notif,
+                                     gpointer user_data);
+
+static GeanyApp host_app;
+static GeanyProject host_project;
+static GeanyMainWidgets host_widgets;
+static GeanyData host_data;
+static GeanyPlugin host_plugin;
+static PluginInfo host_info;
+
+static GeanyKeyBinding host_binding;
+static gint64 host_key_group;  // opaque to plugins
+static gboolean host_resident = false;
+static gboolean host_realized = true;
+static guint host_signal_connects = 0;
+
+// Geany signals the host emits itself
+struct HostSignal {
+  char const *name;
+  GCallback callback;
+  gpointer user_data;
+};
+
+static HostSignal host_signals[] = {
+    {"geany-startup-complete", nullptr, nullptr},
+    {"editor-notify", nullptr, nullptr},
+    {"document-open", nullptr, nullptr},
+    {"project-open", nullptr, nullptr},
+};
+
+static GeanyKeyGroupCallback host_key_callback = nullptr;
+static gint host_switcher_key = -1;
+
+/* ********************
+ * Geany API
+ */
+
+void plugin_signal_connect(GeanyPlugin *plugin, GObject *object,
+                           gchar const *signal_name, gboolean after,
+                           GCallback callback, gpointer user_data) {
+  // Geany disconnects these itself when unloading
+  host_signal_connects++;
+
+  for (auto &sig : host_signals) {
+    if (strcmp(signal_name, sig.name) == 0) {
+      sig.callback = callback;
+      sig.user_data = user_data;
+    }
+  }
+}
+
+GeanyKeyGroup *plugin_set_key_group(GeanyPlugin *plugin,
+                                    gchar const *section_name, gsize count,
+                                    GeanyKeyGroupCallback callback) {
+  host_key_callback = callback;
+  return reinterpret_cast<GeanyKeyGroup *>(&host_key_group);
+}
+
+void plugin_module_make_resident(GeanyPlugin *plugin) {
+  host_resident = true;
+}
+
+void plugin_show_configure(GeanyPlugin *plugin) {}
+
+GeanyKeyBinding *keybindings_set_item(GeanyKeyGroup *group, gsize key_id,
+                                      GeanyKeyCallback callback, guint key,
+                                      GdkModifierType mod,
+                                      gchar const *kf_name,
+                                      gchar const *label,
+                                      GtkWidget *menu_item) {
+  if (g_strcmp0(kf_name, "xitweaks_quick_switcher") == 0) {
+    host_switcher_key = gint(key_id);
+  }
+  return &host_binding;
+}
+
+void keybindings_send_command(guint group_id, guint key_id) {}
+
+GeanyKeyGroup *keybindings_get_core_group(guint id) { return nullptr; }
+
+GtkWidget *ui_lookup_widget(GtkWidget *widget, gchar const *widget_name) {
+  GtkWidget *toplevel = gtk_widget_get_toplevel(widget);
+  return GTK_WIDGET(g_object_get_data(G_OBJECT(toplevel), widget_name));
+}
+
+void ui_add_document_sensitive(GtkWidget *widget) {}
+
+void ui_set_statusbar(gboolean log, gchar const *format, ...) {}
+
+void msgwin_status_add(gchar const *format, ...) {}
+
+gboolean main_is_realized() { return host_realized; }
+
+GeanyDocument *document_get_current() { return nullptr; }
+
+GeanyDocument *document_find_by_id(guint id) { return nullptr; }
+
+gint document_get_notebook_page(GeanyDocument *doc) { return -1; }
+
+GeanyDocument *document_get_from_page(guint page_num) { return nullptr; }
+
+gboolean document_close(GeanyDocument *doc) { return false; }
+
+GeanyDocument *document_open_file(gchar const *locale_filename,
+                                  gboolean readonly, GeanyFiletype *ft,
+                                  gchar const *forced_enc) {
+  return nullptr;
+}
+
+gboolean document_reload_force(GeanyDocument *doc, gchar const *forced_enc) {
+  return false;
+}
+
+GeanyFiletype *filetypes_index(gint idx) { return nullptr; }
+
+static HostSignal const &host_signal(char const *name) {
+  for (auto const &sig : host_signals) {
+    if (strcmp(sig.name, name) == 0) {
+      return sig;
+    }
+  }
+  g_error("no host signal %s", name);
+}
+
+/* ********************
+ * Host Window
+ */
+
+static GtkWidget *add_tree_page(GtkWidget *notebook, char const *title) {
+  GtkListStore *store = gtk_list_store_new(1, G_TYPE_STRING);
+  GtkWidget *view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(store));
+  g_object_unref(store);
+
+  GtkWidget *scroll = gtk_scrolled_window_new(nullptr, nullptr);
+  gtk_container_add(GTK_CONTAINER(scroll), view);
+  gtk_notebook_append_page(GTK_NOTEBOOK(notebook), scroll,
+                           gtk_label_new(title));
+  return scroll;
+}
+
+static GtkWidget *add_text_page(GtkWidget *notebook, char const *title) {
+  GtkWidget *scroll = gtk_scrolled_window_new(nullptr, nullptr);
+  gtk_container_add(GTK_CONTAINER(scroll), gtk_text_view_new());
+  gtk_notebook_append_page(GTK_NOTEBOOK(notebook), scroll,
+                           gtk_label_new(title));
+  return scroll;
+}
+
+static void build_main_window() {
+  GtkWidget *window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+  gtk_window_set_default_size(GTK_WINDOW(window), 800, 600);
+
+  GtkWidget *box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
+  gtk_container_add(GTK_CONTAINER(window), box);
+
+  GtkWidget *menubar = gtk_menu_bar_new();
+  GtkWidget *tools_item = gtk_menu_item_new_with_label("Tools");
+  GtkWidget *tools_menu = gtk_menu_new();
+  gtk_menu_item_set_submenu(GTK_MENU_ITEM(tools_item), tools_menu);
+  gtk_menu_shell_append(GTK_MENU_SHELL(menubar), tools_item);
+  gtk_box_pack_start(GTK_BOX(box), menubar, false, false, 0);
+
+  GtkWidget *vpaned = gtk_paned_new(GTK_ORIENTATION_VERTICAL);
+  GtkWidget *hpaned = gtk_paned_new(GTK_ORIENTATION_HORIZONTAL);
+  gtk_box_pack_start(GTK_BOX(box), vpaned, true, true, 0);
+  gtk_paned_pack1(GTK_PANED(vpaned), hpaned, true, false);
+  g_object_set_data(G_OBJECT(window), "hpaned1", hpaned);
+
+  GtkWidget *sidebar = gtk_notebook_new();
+  add_tree_page(sidebar, "Symbols");
+  add_tree_page(sidebar, "Documents");
+  gtk_paned_pack1(GTK_PANED(hpaned), sidebar, false, false);
+
+  GtkWidget *editor = gtk_notebook_new();
+  for (char const *name : {"one.c", "two.h", "three.py"}) {
+    add_text_page(editor, name);
+  }
+  gtk_paned_pack2(GTK_PANED(hpaned), editor, true, false);
+
+  GtkWidget *msgwin = gtk_notebook_new();
+  add_tree_page(msgwin, "Status");
+  add_tree_page(msgwin, "Compiler");
+  add_tree_page(msgwin, "Messages");
+  add_text_page(msgwin, "Scribble");
+  gtk_paned_pack2(GTK_PANED(vpaned), msgwin, false, false);
+
+  gtk_widget_show_all(window);
+
+  host_widgets.window = window;
+  host_widgets.tools_menu = tools_menu;
+  host_widgets.sidebar_notebook = sidebar;
+  host_widgets.notebook = editor;
+  host_widgets.message_window_notebook = msgwin;
+}
+
+/* ********************
+ * Leak Checks
+ */
+
+// every widget of the main window, and the models and buffers behind them
+static void collect_objects(GtkWidget *widget, std::vector<GObject *> &out) {
+  out.push_back(G_OBJECT(widget));
+
+  if (GTK_IS_TREE_VIEW(widget)) {
+    out.push_back(G_OBJECT(gtk_tree_view_get_model(GTK_TREE_VIEW(widget))));
+  } else if (GTK_IS_TEXT_VIEW(widget)) {
+    out.push_back(G_OBJECT(gtk_text_view_get_buffer(GTK_TEXT_VIEW(widget))));
+  } else if (GTK_IS_MENU_ITEM(widget)) {
+    GtkWidget *submenu = gtk_menu_item_get_submenu(GTK_MENU_ITEM(widget));
+    if (submenu != nullptr) {
+      collect_objects(submenu, out);
+    }
+  }
+
+  if (GTK_IS_NOTEBOOK(widget)) {
+    GtkNotebook *nb = GTK_NOTEBOOK(widget);
+    for (int i = 0; i < gtk_notebook_get_n_pages(nb); i++) {
+      GtkWidget *label =
+          gtk_notebook_get_tab_label(nb, gtk_notebook_get_nth_page(nb, i));
+      if (label != nullptr) {
+        collect_objects(label, out);
+      }
+    }
+  }
+
+  if (GTK_IS_CONTAINER(widget)) {
+    GList *children = gtk_container_get_children(GTK_CONTAINER(widget));
+    for (GList *item = children; item != nullptr; item = item->next) {
+      collect_objects(GTK_WIDGET(item->data), out);
+    }
+    g_list_free(children);
+  }
+}
+
+// Blocking by signal id returns the number of handlers matched.
+static guint count_handlers(GObject *object) {
+  guint count = 0;
+
+  for (GType type = G_OBJECT_TYPE(object); type != 0;
+       type = g_type_parent(type)) {
+    guint n_ids = 0;
+    guint *ids = g_signal_list_ids(type, &n_ids);
+    for (guint i = 0; i < n_ids; i++) {
+      count += g_signal_handlers_block_matched(
+          object, G_SIGNAL_MATCH_ID, ids[i], 0, nullptr, nullptr, nullptr);
+      g_signal_handlers_unblock_matched(object, G_SIGNAL_MATCH_ID, ids[i], 0,
+                                        nullptr, nullptr, nullptr);
+    }
+    g_free(ids);
+  }
+
+  return count;
+}
+
+static guint count_all_handlers() {
+  std::vector<GObject *> objects;
+  collect_objects(host_widgets.window, objects);
+
+  guint count = 0;
+  for (GObject *object : objects) {
+    count += count_handlers(object);
+  }
+  return count;
+}
+
+static guint count_instances(GType type) {
+  guint count = g_type_get_instance_count(type);
+
+  guint n_children = 0;
+  GType *children = g_type_children(type, &n_children);
+  for (guint i = 0; i < n_children; i++) {
+    count += count_instances(children[i]);
+  }
+  g_free(children);
+
+  return count;
+}
+
+static gboolean instance_count_enabled() {
+  char const *debug = g_getenv("GOBJECT_DEBUG");
+  return debug != nullptr && strstr(debug, "instance-count") != nullptr;
+}
+
+static gboolean source_noop(gpointer user_data) { return false; }
+
+// source ids are handed out in order
+static guint next_source_id() {
+  guint id = g_idle_add(source_noop, nullptr);
+  g_source_remove(id);
+  return id;
+}
+
+static guint count_sources(guint first_id, guint last_id) {
+  guint count = 0;
+  for (guint id = first_id; id < last_id; id++) {
+    if (g_main_context_find_source_by_id(nullptr, id) != nullptr) {
+      count++;
+    }
+  }
+  return count;
+}
+
+// bounded, so a source that never finishes is reported instead of hanging
+static void drain_main_loop() {
+  for (int i = 0; i < 1000 && g_main_context_iteration(nullptr, false); i++) {
+  }
+}
+
+static void remove_tree(char const *path) {
+  if (g_file_test(path, G_FILE_TEST_IS_DIR)) {
+    GDir *dir = g_dir_open(path, 0, nullptr);
+    char const *name;
+    while (dir != nullptr && (name = g_dir_read_name(dir)) != nullptr) {
+      gchar *child = g_build_filename(path, name, nullptr);
+      remove_tree(child);
+      g_free(child);
+    }
+    if (dir != nullptr) {
+      g_dir_close(dir);
+    }
+  }
+  g_remove(path);
+}
+
+static gint64 percentile(std::vector<gint64> const &sorted, double p) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  size_t index = size_t(p * (sorted.size() - 1) + 0.5);
+  return sorted[std::min(index, sorted.size() - 1)];
+}
+
+static void print_times(char const *name, std::vector<gint64> &times) {
+  std::sort(times.begin(), times.end());
+
+  double total = 0;
+  for (gint64 t : times) {
+    total += t;
+  }
+
+  printf("%-16s mean %8.1f  p50 %6lld  p99 %6lld  max %6lld us\n", name,
+         times.empty() ? 0.0 : total / times.size(),
+         (long long)percentile(times, 0.50),
+         (long long)percentile(times, 0.99),
+         (long long)percentile(times, 1.0));
+}
+
+static void write_config(gboolean enabled, gboolean compact) {
+  char const *value = enabled ? "true" : "false";
+  gchar *conf_dn =
+      g_build_filename(host_app.configdir, "plugins", "xitweaks", nullptr);
+  gchar *conf_fn = g_build_filename(conf_dn, "xitweaks.conf", nullptr);
+  gchar *contents = g_strdup_printf(
+      "[tweaks]\n"
+      "sidebar_focus_enabled=%s\n"
+      "notebook_focus_enabled=%s\n"
+      "inactive_window_dimmed=%s\n"
+      "doc_state_enabled=%s\n"
+      "tab_activity_enabled=%s\n"
+      "compact_tabs_enabled=%s\n",
+      value, value, value, value, value, compact ? "true" : "false");
+
+  g_mkdir_with_parents(conf_dn, 0755);
+  g_file_set_contents(conf_fn, contents, -1, nullptr);
+
+  g_free(contents);
+  g_free(conf_fn);
+  g_free(conf_dn);
+}
+
+static void setup_host() {
+  host_app.configdir =
+      g_dir_make_tmp("xi-tweaks-lifecycle-XXXXXX", nullptr);
+  host_app.project = nullptr;
+
+  // everything that connects handlers or adds classes
+  write_config(true, true);
+
+  build_main_window();
+
+  // without a window manager, focus has to be asked for
+  gtk_window_present(GTK_WINDOW(host_widgets.window));
+  drain_main_loop();
+  if (!gtk_window_is_active(GTK_WINDOW(host_widgets.window))) {
+    fprintf(stderr, "window is not active; highlight passes are deferred\n");
+  }
+
+  host_data.app = &host_app;
+  host_data.main_widgets = &host_widgets;
+  host_data.documents_array = g_ptr_array_new();
+  host_data.filetypes_array = g_ptr_array_new();
+  host_data.object = G_OBJECT(g_object_new(G_TYPE_OBJECT, nullptr));
+
+  host_plugin.info = &host_info;
+  host_plugin.geany_data = &host_data;
+}
+
+struct HostModule {
+  GModule *module = nullptr;
+  InitFunc init = nullptr;
+  CleanupFunc cleanup = nullptr;
+  ConfigureFunc configure = nullptr;  // optional
+};
+
+// Loads the plugin the way Geany loads legacy plugins.
+static bool open_plugin(char const *filename, HostModule &host) {
+  host.module = g_module_open(filename, G_MODULE_BIND_LOCAL);
+  if (host.module == nullptr) {
+    fprintf(stderr, "%s\n", g_module_error());
+    return false;
+  }
+
+  VersionCheckFunc version_check = nullptr;
+  SetInfoFunc set_info = nullptr;
+  GeanyPlugin **plugin_var = nullptr;
+  GeanyData **data_var = nullptr;
+
+  if (!g_module_symbol(host.module, "plugin_version_check",
+                       (gpointer *)&version_check) ||
+      !g_module_symbol(host.module, "plugin_set_info",
+                       (gpointer *)&set_info) ||
+      !g_module_symbol(host.module, "plugin_init", (gpointer *)&host.init) ||
+      !g_module_symbol(host.module, "plugin_cleanup",
+                       (gpointer *)&host.cleanup) ||
+      !g_module_symbol(host.module, "geany_plugin", (gpointer *)&plugin_var) ||
+      !g_module_symbol(host.module, "geany_data", (gpointer *)&data_var)) {
+    fprintf(stderr, "%s: not a Geany plugin\n", filename);
+    return false;
+  }
+  g_module_symbol(host.module, "plugin_configure",
+                  (gpointer *)&host.configure);
+  if (version_check(GEANY_ABI_VERSION) < 0) {
+    fprintf(stderr, "%s: built for another Geany ABI\n", filename);
+    return false;
+  }
+
+  set_info(&host_info);
+  *plugin_var = &host_plugin;
+  *data_var = &host_data;
+  return true;
+}
+
+static void close_plugin(HostModule &host) {
+  if (host_resident) {
+    g_module_make_resident(host.module);
+  }
+  g_module_close(host.module);
+  host = HostModule();
+}
+
+// A project whose [xitweaks] group turns compact tabs off.
+static void open_project() {
+  auto const &project_open = host_signal("project-open");
+  if (project_open.callback == nullptr) {
+    return;
+  }
+
+  host_project.name = const_cast<gchar *>("lifecycle");
+  host_project.file_name = g_build_filename(
+      host_app.configdir, "lifecycle.geany", nullptr);
+  host_project.base_path = host_app.configdir;
+  host_app.project = &host_project;
+
+  GKeyFile *kf = g_key_file_new();
+  g_key_file_set_boolean(kf, "xitweaks", "compact_tabs_enabled", false);
+  g_key_file_set_string(kf, "xitweaks", "tab_style_lifecycle", "*.c");
+  reinterpret_cast<ProjectOpenFunc>(project_open.callback)(
+      host_data.object, kf, project_open.user_data);
+  g_key_file_free(kf);
+}
+
+static void close_project() {
+  host_app.project = nullptr;
+  g_free(host_project.file_name);
+  host_project.file_name = nullptr;
+}
+
+// compact_tabs_enabled is on in the config
+static gboolean editor_tabs_compact() {
+  GtkNotebook *nb = GTK_NOTEBOOK(host_widgets.notebook);
+  GtkWidget *label =
+      gtk_notebook_get_tab_label(nb, gtk_notebook_get_nth_page(nb, 0));
+  return gtk_style_context_has_class(gtk_widget_get_style_context(label),
+                                     "xitweaks-compact-tab");
+}
+
+static int run_cycles(char const *plugin_fn, int cycles) {
+  guint handlers_before = count_all_handlers();
+  guint objects_before = 0;
+  guint sources_left = 0;
+  guint stale_projects = 0;
+  std::vector<gint64> init_times, cleanup_times;
+
+  for (int i = 0; i < cycles; i++) {
+    HostModule host;
+    if (!open_plugin(plugin_fn, host)) {
+      return 2;
+    }
+
+    guint first_source = next_source_id();
+
+    gint64 start = g_get_monotonic_time();
+    host.init(&host_data);
+    init_times.push_back(g_get_monotonic_time() - start);
+
+    // deferred work, such as loading the config, runs as in Geany
+    drain_main_loop();
+
+    // the project closed while unloaded must be gone
+    if (i % 2 == 0 && i > 0 && !editor_tabs_compact()) {
+      stale_projects++;
+    }
+    if (i % 2 != 0) {
+      open_project();
+      drain_main_loop();
+    }
+
+    start = g_get_monotonic_time();
+    host.cleanup();
+    cleanup_times.push_back(g_get_monotonic_time() - start);
+
+    drain_main_loop();
+    sources_left += count_sources(first_source, next_source_id());
+
+    close_plugin(host);
+    close_project();
+
+    // the first cycle fills caches and registers types
+    if (i == 0) {
+      objects_before = count_instances(G_TYPE_OBJECT);
+    }
+  }
+
+  gint handlers_left = gint(count_all_handlers()) - gint(handlers_before);
+  gboolean counting = instance_count_enabled();
+  gint objects_left = gint(count_instances(G_TYPE_OBJECT)) -
+                      gint(objects_before);
+
+  printf("cycles           %d\n", cycles);
+  print_times("plugin_init", init_times);
+  print_times("plugin_cleanup", cleanup_times);
+  printf("signal connects  %u per cycle\n", host_signal_connects / cycles);
+  printf("resident         %s\n", host_resident ? "yes" : "no");
+  if (counting) {
+    printf("leaked objects   %d over %d cycles\n", objects_left, cycles - 1);
+  } else {
+    printf("leaked objects   not counted; set GOBJECT_DEBUG=instance-count\n");
+  }
+  printf("dangling handlers %d\n", handlers_left);
+  printf("pending sources  %u\n", sources_left);
+  printf("stale projects   %u\n", stale_projects);
+
+  return (counting && objects_left > 0) || handlers_left > 0 ||
+                 sources_left > 0 || stale_projects > 0
+             ? 1
+             : 0;
+}
+
+/* ********************
+ * Soak
+ */
+
+struct SoakSample {
+  gint64 time_us;
+  gint64 rss_kb;
+  gint64 objects;
+  gint64 handlers;
+};
+
+static gint64 read_rss_kb() {
+  long size = 0, resident = 0;
+  FILE *fp = fopen("/proc/self/statm", "r");
+  if (fp != nullptr) {
+    if (fscanf(fp, "%ld %ld", &size, &resident) != 2) {
+      resident = 0;
+    }
+    fclose(fp);
+  }
+  return gint64(resident) * sysconf(_SC_PAGESIZE) / 1024;
+}
+
+static GtkWidget *find_menu_item(GtkWidget *menu, char const *label) {
+  GtkWidget *found = nullptr;
+
+  GList *children = gtk_container_get_children(GTK_CONTAINER(menu));
+  for (GList *item = children; item != nullptr; item = item->next) {
+    GtkWidget *child = GTK_WIDGET(item->data);
+    char const *text = GTK_IS_MENU_ITEM(child)
+                           ? gtk_menu_item_get_label(GTK_MENU_ITEM(child))
+                           : nullptr;
+    if (text != nullptr && strcmp(text, label) == 0) {
+      found = child;
+      break;
+    }
+  }
+  g_list_free(children);
+
+  return found;
+}
+
+static GtkWidget *find_reload_item() {
+  GtkWidget *tweaks_item =
+      find_menu_item(host_widgets.tools_menu, "Xi/Tweaks");
+  return tweaks_item != nullptr
+             ? find_menu_item(
+                   gtk_menu_item_get_submenu(GTK_MENU_ITEM(tweaks_item)),
+                   "Reload Config File")
+             : nullptr;
+}
+
+static void focus_page(GtkWidget *notebook, gint page_num) {
+  gtk_notebook_set_current_page(GTK_NOTEBOOK(notebook), page_num);
+  GtkWidget *page =
+      gtk_notebook_get_nth_page(GTK_NOTEBOOK(notebook), page_num);
+  gtk_widget_grab_focus(gtk_bin_get_child(GTK_BIN(page)));
+  drain_main_loop();
+}
+
+// Opens and closes a batch of documents, moves focus around, floods a
+// hidden message window tab, and reloads the config through the menu.
+static void soak_round(int round, GtkWidget *reload_item) {
+  GtkWidget *editor = host_widgets.notebook;
+  GtkWidget *msgwin = host_widgets.message_window_notebook;
+  GtkWidget *sidebar = host_widgets.sidebar_notebook;
+
+  std::vector<GtkWidget *> pages;
+  for (int i = 0; i < 20; i++) {
+    gchar *name = g_strdup_printf("soak-%d-%d.c", round, i);
+    GtkWidget *page = add_text_page(editor, name);
+    gtk_widget_show_all(page);
+    pages.push_back(page);
+    g_free(name);
+  }
+  drain_main_loop();
+
+  for (GtkWidget *page : pages) {
+    focus_page(editor, gtk_notebook_page_num(GTK_NOTEBOOK(editor), page));
+  }
+  focus_page(sidebar, round % 2);
+  focus_page(msgwin, 0);
+
+  // compiler output while the status tab is shown
+  GtkWidget *compiler = gtk_bin_get_child(
+      GTK_BIN(gtk_notebook_get_nth_page(GTK_NOTEBOOK(msgwin), 1)));
+  GtkListStore *store = GTK_LIST_STORE(
+      gtk_tree_view_get_model(GTK_TREE_VIEW(compiler)));
+  for (int i = 0; i < 1000; i++) {
+    gtk_list_store_insert_with_values(store, nullptr, -1, 0, "output", -1);
+  }
+  focus_page(msgwin, 1);
+  gtk_list_store_clear(store);
+
+  for (GtkWidget *page : pages) {
+    gtk_widget_destroy(page);
+  }
+  drain_main_loop();
+
+  // turn every feature off and on again
+  write_config(round % 2 != 0, round % 2 != 0);
+  gtk_menu_item_activate(GTK_MENU_ITEM(reload_item));
+  drain_main_loop();
+}
+
+// Growth in every quarter of the run, and by more than slack overall, is
+// taken as unbounded.  Noise makes at least one quarter flat or lower.
+static bool grows(std::vector<SoakSample> const &samples,
+                  gint64 SoakSample::*field, gint64 slack) {
+  size_t quarter = samples.size() / 4;
+  if (quarter == 0) {
+    return false;
+  }
+
+  double means[4];
+  for (int q = 0; q < 4; q++) {
+    double total = 0;
+    for (size_t i = q * quarter; i < (q + 1) * quarter; i++) {
+      total += samples[i].*field;
+    }
+    means[q] = total / quarter;
+  }
+
+  return means[1] > means[0] && means[2] > means[1] && means[3] > means[2] &&
+         samples.back().*field - samples.front().*field > slack;
+}
+
+static int run_soak(char const *plugin_fn, int seconds) {
+  HostModule host;
+  if (!open_plugin(plugin_fn, host)) {
+    return 2;
+  }
+  host.init(&host_data);
+  drain_main_loop();
+
+  GtkWidget *reload_item = find_reload_item();
+  if (reload_item == nullptr) {
+    fprintf(stderr, "%s: no Reload Config File menu item\n", plugin_fn);
+    return 2;
+  }
+
+  gboolean counting = instance_count_enabled();
+  std::vector<SoakSample> samples;
+  gint64 start = g_get_monotonic_time();
+  gint64 end = start + gint64(seconds) * G_USEC_PER_SEC;
+  gint64 next_sample = start;
+  int rounds = 0;
+
+  while (g_get_monotonic_time() < end) {
+    soak_round(rounds++, reload_item);
+
+    gint64 now = g_get_monotonic_time();
+    if (now >= next_sample) {
+      SoakSample sample;
+      sample.time_us = now - start;
+      sample.rss_kb = read_rss_kb();
+      sample.objects = counting ? count_instances(G_TYPE_OBJECT) : 0;
+      sample.handlers = count_all_handlers();
+      samples.push_back(sample);
+      next_sample = now + G_USEC_PER_SEC;
+    }
+  }
+
+  host.cleanup();
+  drain_main_loop();
+  close_plugin(host);
+
+  // the first tenth settles caches and the allocator
+  samples.erase(samples.begin(), samples.begin() + samples.size() / 10);
+
+  for (SoakSample const &sample : samples) {
+    printf("%8.1f s  rss %8lld kB  objects %8lld  handlers %6lld\n",
+           sample.time_us / 1e6, (long long)sample.rss_kb,
+           (long long)sample.objects, (long long)sample.handlers);
+  }
+
+  bool rss_grows = grows(samples, &SoakSample::rss_kb, 1024);
+  bool objects_grow = counting && grows(samples, &SoakSample::objects, 0);
+  bool handlers_grow = grows(samples, &SoakSample::handlers, 0);
+
+  printf("rounds           %d in %d s\n", rounds, seconds);
+  printf("rss              %s\n", rss_grows ? "grows" : "bounded");
+  if (counting) {
+    printf("objects          %s\n", objects_grow ? "grow" : "bounded");
+  } else {
+    printf("objects          not counted; set GOBJECT_DEBUG=instance-count\n");
+  }
+  printf("handlers         %s\n", handlers_grow ? "grow" : "bounded");
+
+  return rss_grows || objects_grow || handlers_grow ? 1 : 0;
+}
+
+/* ********************
+ * Tab Strip
+ */
+
+// an editor tab label as Geany builds it
+static void add_document_page(GtkWidget *notebook, char const *title) {
+  GtkWidget *button = gtk_button_new();
+  gtk_button_set_relief(GTK_BUTTON(button), GTK_RELIEF_NONE);
+  gtk_container_add(
+      GTK_CONTAINER(button),
+      gtk_image_new_from_icon_name("window-close", GTK_ICON_SIZE_MENU));
+
+  GtkWidget *hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 2);
+  gtk_box_pack_start(GTK_BOX(hbox), gtk_label_new(title), false, false, 0);
+  gtk_box_pack_start(GTK_BOX(hbox), button, false, false, 0);
+
+  GtkWidget *ebox = gtk_event_box_new();
+  gtk_widget_set_has_window(ebox, false);
+  gtk_container_add(GTK_CONTAINER(ebox), hbox);
+  gtk_widget_show_all(ebox);
+
+  GtkWidget *scroll = gtk_scrolled_window_new(nullptr, nullptr);
+  gtk_container_add(GTK_CONTAINER(scroll), gtk_text_view_new());
+  gtk_widget_show_all(scroll);
+  gtk_notebook_append_page(GTK_NOTEBOOK(notebook), scroll, ebox);
+}
+
+static guint count_widgets(GtkWidget *widget) {
+  guint count = 1;
+
+  if (GTK_IS_CONTAINER(widget)) {
+    GList *children = gtk_container_get_children(GTK_CONTAINER(widget));
+    for (GList *item = children; item != nullptr; item = item->next) {
+      count += count_widgets(GTK_WIDGET(item->data));
+    }
+    g_list_free(children);
+  }
+  return count;
+}
+
+static guint count_tab_widgets(GtkNotebook *nb) {
+  guint count = 0;
+  for (int i = 0; i < gtk_notebook_get_n_pages(nb); i++) {
+    count += count_widgets(
+        gtk_notebook_get_tab_label(nb, gtk_notebook_get_nth_page(nb, i)));
+  }
+  return count;
+}
+
+// Restyles every tab and lays the notebook out again, as a theme or font
+// change does.
+static gint64 relayout(GtkWidget *notebook) {
+  gint64 start = g_get_monotonic_time();
+
+  gtk_widget_reset_style(notebook);
+  gtk_widget_queue_resize(notebook);
+
+  GtkRequisition minimum, natural;
+  gtk_widget_get_preferred_size(notebook, &minimum, &natural);
+  GtkAllocation allocation;
+  gtk_widget_get_allocation(notebook, &allocation);
+  gtk_widget_size_allocate(notebook, &allocation);
+
+  return g_get_monotonic_time() - start;
+}
+
+// Tab strip relayout with Geany's tab labels and with compact ones, with
+// the plugin loaded and every other feature on in both cases.
+static int run_tabs(char const *plugin_fn, int tabs) {
+  GtkWidget *editor = host_widgets.notebook;
+  gtk_notebook_set_scrollable(GTK_NOTEBOOK(editor), true);
+  for (int i = 0; i < tabs; i++) {
+    gchar *name = g_strdup_printf("document-%d.c", i);
+    add_document_page(editor, name);
+    g_free(name);
+  }
+
+  write_config(true, false);
+
+  HostModule host;
+  if (!open_plugin(plugin_fn, host)) {
+    return 2;
+  }
+  host.init(&host_data);
+  drain_main_loop();
+
+  GtkWidget *reload_item = find_reload_item();
+  if (reload_item == nullptr) {
+    fprintf(stderr, "%s: no Reload Config File menu item\n", plugin_fn);
+    return 2;
+  }
+
+  std::vector<gint64> times[2];
+  guint widgets[2];
+  for (int compact = 0; compact < 2; compact++) {
+    write_config(true, compact);
+    gtk_menu_item_activate(GTK_MENU_ITEM(reload_item));
+    drain_main_loop();
+
+    widgets[compact] = count_tab_widgets(GTK_NOTEBOOK(editor));
+    for (int i = 0; i < 50; i++) {
+      times[compact].push_back(relayout(editor));
+    }
+  }
+
+  host.cleanup();
+  drain_main_loop();
+  close_plugin(host);
+
+  printf("tabs             %d\n", tabs);
+  printf("tab widgets      %u full, %u compact\n", widgets[0], widgets[1]);
+  print_times("relayout full", times[0]);
+  print_times("relayout compact", times[1]);
+
+  return 0;
+}
+
+/* ********************
+ * Startup
+ */
+
+// one line of the statistics the plugin exports at cleanup
+static guint64 read_stat(gchar const *stats, char const *name) {
+  guint64 value = 0;
+  gchar **lines = g_strsplit(stats, "\n", -1);
+  for (gchar **line = lines; *line != nullptr; line++) {
+    gchar *text = g_strstrip(*line);
+    if (g_str_has_prefix(text, name) &&
+        g_ascii_isspace(text[strlen(name)])) {
+      value = g_ascii_strtoull(text + strlen(name), nullptr, 10);
+      break;
+    }
+  }
+  g_strfreev(lines);
+  return value;
+}
+
+// A restored session: documents are added while the plugin bulk loads,
+// and one pass styles them all once loading ends.
+static int run_startup(char const *plugin_fn, int doc_count) {
+  gchar *stats_fn = g_build_filename(host_app.configdir, "stats.txt", nullptr);
+  g_setenv("XITWEAKS_STATS_FILE", stats_fn, true);
+  write_config(true, false);
+
+  HostModule host;
+  if (!open_plugin(plugin_fn, host)) {
+    return 2;
+  }
+  host_realized = false;
+  host.init(&host_data);
+  drain_main_loop();
+
+  auto const &startup = host_signal("geany-startup-complete");
+  if (startup.callback == nullptr) {
+    fprintf(stderr, "%s: %s not connected\n", plugin_fn, startup.name);
+    return 2;
+  }
+
+  GtkWidget *editor = host_widgets.notebook;
+  gint64 start = g_get_monotonic_time();
+  for (int i = 0; i < doc_count; i++) {
+    gchar *name = g_strdup_printf("document-%d.c", i);
+    add_document_page(editor, name);
+    g_free(name);
+  }
+  drain_main_loop();
+  gint64 restore_us = g_get_monotonic_time() - start;
+
+  host_realized = true;
+  start = g_get_monotonic_time();
+  reinterpret_cast<StartupFunc>(startup.callback)(host_data.object,
+                                                  startup.user_data);
+  drain_main_loop();
+  gint64 settle_us = g_get_monotonic_time() - start;
+
+  host.cleanup();
+  drain_main_loop();
+  close_plugin(host);
+  g_unsetenv("XITWEAKS_STATS_FILE");
+
+  gchar *stats = nullptr;
+  if (!g_file_get_contents(stats_fn, &stats, nullptr, nullptr)) {
+    fprintf(stderr, "%s: no statistics written\n", stats_fn);
+    g_free(stats_fn);
+    return 2;
+  }
+  g_free(stats_fn);
+
+  printf("documents        %d\n", doc_count);
+  printf("restore          %lld us\n", (long long)restore_us);
+  printf("startup complete %lld us until idle\n", (long long)settle_us);
+  printf("passes run       %llu\n",
+         (unsigned long long)read_stat(stats, "run"));
+  printf("passes deferred  %llu\n",
+         (unsigned long long)read_stat(stats, "deferred by bulk load"));
+  printf("pages visited    %llu\n",
+         (unsigned long long)read_stat(stats, "pages visited"));
+  g_free(stats);
+
+  return 0;
+}
+
+/* ********************
+ * Inactive Window
+ */
+
+static guint host_focus_outs = 0;
+static guint host_name_writes = 0;
+
+// what Scintilla reports when the editor loses focus
+static gboolean on_editor_focus_out(GtkWidget *widget, GdkEvent *event,
+                                    gpointer user_data) {
+  auto const &notify = host_signal("editor-notify");
+  if (notify.callback != nullptr) {
+    GeanyEditor editor = {};
+    SCNotification notif = {};
+    notif.nmhdr.code = SCN_FOCUSOUT;
+    reinterpret_cast<EditorNotifyFunc>(notify.callback)(
+        host_data.object, &editor, &notif, notify.user_data);
+    host_focus_outs++;
+  }
+  return false;
+}
+
+static void on_name_written(GObject *object, GParamSpec *pspec,
+                            gpointer user_data) {
+  host_name_writes++;
+}
+
+// the tab labels and pages of every notebook, which passes name
+static void watch_names(gboolean watch) {
+  GtkWidget *notebooks[] = {host_widgets.sidebar_notebook,
+                            host_widgets.message_window_notebook,
+                            host_widgets.notebook};
+  for (GtkWidget *widget : notebooks) {
+    GtkNotebook *nb = GTK_NOTEBOOK(widget);
+    for (int i = 0; i < gtk_notebook_get_n_pages(nb); i++) {
+      GtkWidget *page = gtk_notebook_get_nth_page(nb, i);
+      for (GtkWidget *named : {page, gtk_notebook_get_tab_label(nb, page)}) {
+        if (watch) {
+          g_signal_connect(named, "notify::name", G_CALLBACK(on_name_written),
+                           nullptr);
+        } else {
+          g_signal_handlers_disconnect_by_func(
+              named, (gpointer)on_name_written, nullptr);
+        }
+      }
+    }
+  }
+}
+
+static GtkWidget *find_check_button(GtkWidget *widget, char const *label) {
+  if (GTK_IS_CHECK_BUTTON(widget)) {
+    char const *text = gtk_button_get_label(GTK_BUTTON(widget));
+    return text != nullptr && strcmp(text, label) == 0 ? widget : nullptr;
+  }
+  if (!GTK_IS_CONTAINER(widget)) {
+    return nullptr;
+  }
+
+  GtkWidget *found = nullptr;
+  GList *children = gtk_container_get_children(GTK_CONTAINER(widget));
+  for (GList *item = children; item != nullptr && found == nullptr;
+       item = item->next) {
+    found = find_check_button(GTK_WIDGET(item->data), label);
+  }
+  g_list_free(children);
+
+  return found;
+}
+
+// Switching to another application and back must leave the styles alone.
+// Without a window manager, presenting a window moves the input focus.
+static int run_inactive(char const *plugin_fn, int rounds) {
+  write_config(true, false);
+
+  HostModule host;
+  if (!open_plugin(plugin_fn, host)) {
+    return 2;
+  }
+  host.init(&host_data);
+  drain_main_loop();
+
+  GtkWindow *main_window = GTK_WINDOW(host_widgets.window);
+  GtkWidget *other = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+  gtk_widget_show_all(other);
+
+  focus_page(host_widgets.notebook, 0);
+  GtkWidget *view = gtk_window_get_focus(main_window);
+  g_signal_connect(view, "focus-out-event", G_CALLBACK(on_editor_focus_out),
+                   nullptr);
+  watch_names(true);
+
+  // the same config, so a reload changes nothing either
+  GtkWidget *reload_item = find_reload_item();
+  int deactivated = 0;
+  for (int i = 0; i < rounds; i++) {
+    gtk_window_present(GTK_WINDOW(other));
+    drain_main_loop();
+    deactivated += !gtk_window_is_active(main_window);
+
+    if (i % 2 != 0 && reload_item != nullptr) {
+      gtk_menu_item_activate(GTK_MENU_ITEM(reload_item));
+      drain_main_loop();
+    }
+
+    gtk_window_present(main_window);
+    drain_main_loop();
+  }
+  guint round_writes = host_name_writes;
+  g_signal_handlers_disconnect_by_func(view, (gpointer)on_editor_focus_out,
+                                       nullptr);
+
+  // the preferences dialog holds the focus while a toggle is flipped
+  GtkWidget *dialog = gtk_dialog_new();
+  GtkWidget *prefs =
+      host.configure != nullptr ? host.configure(GTK_DIALOG(dialog)) : nullptr;
+  gtk_container_add(
+      GTK_CONTAINER(gtk_dialog_get_content_area(GTK_DIALOG(dialog))),
+      prefs != nullptr ? prefs : gtk_label_new(nullptr));
+  GtkWidget *toggle =
+      prefs != nullptr
+          ? find_check_button(prefs,
+                              "Highlight the focused tab in every notebook")
+          : nullptr;
+
+  GtkNotebook *editor = GTK_NOTEBOOK(host_widgets.notebook);
+  GtkWidget *tab = gtk_notebook_get_tab_label(
+      editor, gtk_notebook_get_nth_page(editor, 0));
+  guint toggle_writes = 0;
+  guint missed = 0;
+  for (int i = 0; toggle != nullptr && i < 2 * rounds; i++) {
+    gtk_widget_show_all(dialog);
+    gtk_window_present(GTK_WINDOW(dialog));
+    drain_main_loop();
+
+    guint before = host_name_writes;
+    gboolean on = !gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(toggle));
+    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(toggle), on);
+    drain_main_loop();
+    toggle_writes += host_name_writes - before;
+
+    gtk_widget_hide(dialog);
+    gtk_window_present(main_window);
+    drain_main_loop();
+    missed += strcmp(gtk_widget_get_name(tab),
+                     on ? "geany-xitweaks-notebook-tab-focus"
+                        : "geany-xitweaks-notebook-tab-unfocus") != 0;
+  }
+
+  watch_names(false);
+  gtk_widget_destroy(dialog);
+  gtk_widget_destroy(other);
+
+  host.cleanup();
+  drain_main_loop();
+  close_plugin(host);
+
+  printf("deactivations    %d of %d\n", deactivated, rounds);
+  printf("editor focus-out %u\n", host_focus_outs);
+  printf("style writes     %u\n", round_writes);
+  printf("toggle writes    %u while inactive\n", toggle_writes);
+  printf("toggles missed   %u of %d\n", missed,
+         toggle != nullptr ? 2 * rounds : 0);
+
+  // nothing was tested; 77 tells meson to skip
+  if (deactivated == 0 || host_focus_outs == 0) {
+    fprintf(stderr, "the main window never lost focus\n");
+    return 77;
+  }
+  if (toggle == nullptr) {
+    fprintf(stderr, "%s: no highlight toggle in the preferences\n",
+            plugin_fn);
+    return 1;
+  }
+  return round_writes > 0 || toggle_writes > 0 || missed > 0 ? 1 : 0;
+}
+
+/* ********************
+ * Quick Switcher
+ */
+
+typedef void (*DocumentFunc)(GObject *object, GeanyDocument *doc,
+                             gpointer user_data);
+
+static GtkWidget *find_toplevel(char const *name) {
+  GtkWidget *found = nullptr;
+
+  GList *toplevels = gtk_window_list_toplevels();
+  for (GList *item = toplevels; item != nullptr; item = item->next) {
+    if (g_strcmp0(gtk_widget_get_name(GTK_WIDGET(item->data)), name) == 0) {
+      found = GTK_WIDGET(item->data);
+      break;
+    }
+  }
+  g_list_free(toplevels);
+
+  return found;
+}
+
+// Keystroke latency of the quick switcher, from typing to updated results.
+static int run_switcher(char const *plugin_fn, int doc_count) {
+  static char const *dirs[] = {"src/core", "src/net",  "src/ui", "include",
+                               "tests",    "docs",     "tools",
+                               "third_party/zlib"};
+  static char const *stems[] = {"socket", "window", "buffer", "parser",
+                                "config", "main",   "util",   "inflate",
+                                "render", "events", "cache",  "test_io"};
+  static char const *exts[] = {".c", ".h", ".cc", ".py"};
+  static char const *queries[] = {"sockt", "ui/win", "zlib", "testmain",
+                                  "cfg.h", "xyzzy"};
+
+  write_config(false, false);
+
+  HostModule host;
+  if (!open_plugin(plugin_fn, host)) {
+    return 2;
+  }
+  host.init(&host_data);
+  drain_main_loop();
+
+  auto const &open = host_signal("document-open");
+  if (open.callback == nullptr || host_key_callback == nullptr ||
+      host_switcher_key < 0) {
+    fprintf(stderr, "%s: no document-open handler or switcher key\n",
+            plugin_fn);
+    return 2;
+  }
+
+  std::vector<GeanyDocument> docs(doc_count);
+  for (int i = 0; i < doc_count; i++) {
+    docs[i].is_valid = true;
+    docs[i].id = i + 1;
+    docs[i].file_name = g_strdup_printf(
+        "/home/user/project/%s/%s_%d%s", dirs[i % G_N_ELEMENTS(dirs)],
+        stems[i % G_N_ELEMENTS(stems)], i, exts[i % G_N_ELEMENTS(exts)]);
+    reinterpret_cast<DocumentFunc>(open.callback)(host_data.object, &docs[i],
+                                                  open.user_data);
+  }
+
+  host_key_callback(host_switcher_key);
+  drain_main_loop();
+
+  GtkWidget *popup = find_toplevel("geany-xitweaks-switcher");
+  GtkWidget *entry =
+      popup != nullptr ? gtk_window_get_focus(GTK_WINDOW(popup)) : nullptr;
+  if (entry == nullptr || !GTK_IS_ENTRY(entry)) {
+    fprintf(stderr, "%s: quick switcher did not open\n", plugin_fn);
+    return 2;
+  }
+
+  std::vector<gint64> times;
+  for (int round = 0; round < 20; round++) {
+    for (char const *query : queries) {
+      for (size_t len = 1; len <= strlen(query); len++) {
+        gchar *typed = g_strndup(query, len);
+        gint64 start = g_get_monotonic_time();
+        gtk_entry_set_text(GTK_ENTRY(entry), typed);
+        times.push_back(g_get_monotonic_time() - start);
+        g_free(typed);
+      }
+    }
+  }
+
+  host.cleanup();
+  drain_main_loop();
+  close_plugin(host);
+
+  for (GeanyDocument &doc : docs) {
+    g_free(doc.file_name);
+  }
+
+  printf("documents        %d\n", doc_count);
+  printf("keystrokes       %zu\n", times.size());
+  print_times("query", times);
+  printf("query p95        %lld us\n", (long long)percentile(times, 0.95));
+
+  return 0;
+}
+
+/* ********************
+ * Allocations
+ */
+
+typedef void (*AllocCountingFunc)(int enable);
+typedef guint64 (*AllocCountFunc)();
+
+// the plugin's scheduler source, created when the config was first loaded
+static GSource *find_scheduler_source() {
+  guint last_id = next_source_id();
+  for (guint id = 1; id < last_id; id++) {
+    GSource *source = g_main_context_find_source_by_id(nullptr, id);
+    if (source != nullptr &&
+        g_strcmp0(g_source_get_name(source), "xitweaks-scheduler") == 0) {
+      return source;
+    }
+  }
+  return nullptr;
+}
+
+// Signals the plugin listens to whose default handlers change nothing
+// while focus and the current page stay put.
+static void replay_focus_event(GtkWidget *notebook, int round) {
+  GtkNotebook *nb = GTK_NOTEBOOK(notebook);
+
+  if (round % 2 == 0) {
+    g_signal_emit_by_name(nb, "grab-notify", true);
+  } else {
+    gint cur_page = gtk_notebook_get_current_page(nb);
+    g_signal_emit_by_name(nb, "switch-page",
+                          gtk_notebook_get_nth_page(nb, cur_page),
+                          guint(cur_page));
+  }
+}
+
+// Focus events and the highlight passes they schedule, once every page has
+// been named.  A pass that moves focus still allocates: GTK copies the name
+// in gtk_widget_set_name() for each tab and page whose style changes.
+static int run_allocs(char const *plugin_fn, int rounds) {
+  AllocCountingFunc set_counting = nullptr;
+  AllocCountFunc get_count = nullptr;
+
+  GModule *self = g_module_open(nullptr, G_MODULE_BIND_LAZY);
+  if (!g_module_symbol(self, "xitweaks_alloc_counting",
+                       (gpointer *)&set_counting) ||
+      !g_module_symbol(self, "xitweaks_alloc_count",
+                       (gpointer *)&get_count)) {
+    fprintf(stderr, "allocation counter not loaded; set "
+                    "LD_PRELOAD=xi-tweaks-alloc-count.so\n");
+    g_module_close(self);
+    return 2;
+  }
+  g_module_close(self);
+
+  HostModule host;
+  if (!open_plugin(plugin_fn, host)) {
+    return 2;
+  }
+  host.init(&host_data);
+  drain_main_loop();
+
+  GSource *scheduler = find_scheduler_source();
+  if (scheduler == nullptr) {
+    fprintf(stderr, "%s: no xitweaks-scheduler source\n", plugin_fn);
+    return 2;
+  }
+
+  // name every page, then leave focus in the editor
+  GtkWidget *notebooks[] = {host_widgets.sidebar_notebook,
+                            host_widgets.message_window_notebook,
+                            host_widgets.notebook};
+  for (GtkWidget *nb : notebooks) {
+    focus_page(nb, 0);
+  }
+
+  int passes = 0, allocating = 0;
+  guint64 allocations = 0;
+  for (int i = 0; i < rounds; i++) {
+    drain_main_loop();
+
+    guint64 before = get_count();
+    set_counting(true);
+    replay_focus_event(notebooks[i % G_N_ELEMENTS(notebooks)], i);
+    gboolean scheduled = g_source_get_ready_time(scheduler) == 0;
+    g_main_context_iteration(nullptr, false);
+    gboolean ran = scheduled && g_source_get_ready_time(scheduler) == -1;
+    set_counting(false);
+    guint64 count = get_count() - before;
+
+    passes += ran;
+    allocations += count;
+    if (count != 0 && allocating++ == 0) {
+      fprintf(stderr, "event %d allocated %llu times\n", i,
+              (unsigned long long)count);
+    }
+  }
+
+  host.cleanup();
+  drain_main_loop();
+  close_plugin(host);
+
+  printf("focus events     %d\n", rounds);
+  printf("passes run       %d\n", passes);
+  printf("allocations      %llu in %d events\n",
+         (unsigned long long)allocations, allocating);
+
+  // events that scheduled nothing would pass trivially
+  if (passes < rounds / 2) {
+    fprintf(stderr, "too few passes ran; is the window active?\n");
+    return 2;
+  }
+  return allocating > 0 ? 1 : 0;
+}
+
+/* ********************
+ * Scheduler Priorities
+ */
+
+static guint host_paints = 0;
+
+static void on_after_paint(GdkFrameClock *clock, gpointer user_data) {
+  host_paints++;
+}
+
+// A low priority task queued together with a high priority one must not
+// be pulled into the high priority batch, ahead of GTK's redraw.
+static int run_scheduler(char const *plugin_fn, int rounds) {
+  write_config(true, false);
+
+  HostModule host;
+  if (!open_plugin(plugin_fn, host)) {
+    return 2;
+  }
+  if (host.configure == nullptr) {
+    fprintf(stderr, "%s: no plugin_configure\n", plugin_fn);
+    return 2;
+  }
+  host.init(&host_data);
+  focus_page(host_widgets.notebook, 0);
+
+  GdkFrameClock *clock = gtk_widget_get_frame_clock(host_widgets.window);
+  g_signal_connect(clock, "after-paint", G_CALLBACK(on_after_paint),
+                   nullptr);
+
+  int split = 0, joined = 0, painted = 0;
+  for (int i = 0; i < rounds; i++) {
+    GtkWidget *dialog = gtk_dialog_new();
+    gtk_container_add(
+        GTK_CONTAINER(gtk_dialog_get_content_area(GTK_DIALOG(dialog))),
+        host.configure(GTK_DIALOG(dialog)));
+    GtkWidget *toggle = find_check_button(
+        dialog, "Dim focus styles while the window is inactive");
+    if (toggle != nullptr) {
+      gtk_toggle_button_set_active(
+          GTK_TOGGLE_BUTTON(toggle),
+          !gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(toggle)));
+    }
+    gtk_widget_destroy(dialog);
+    replay_focus_event(host_widgets.notebook, i);
+
+    GSource *scheduler = find_scheduler_source();
+    if (scheduler == nullptr) {
+      fprintf(stderr, "%s: no xitweaks-scheduler source\n", plugin_fn);
+      return 2;
+    }
+    if (g_source_get_priority(scheduler) != G_PRIORITY_HIGH_IDLE) {
+      fprintf(stderr, "round %d: no highlight pass queued\n", i);
+      continue;
+    }
+
+    // the dispatch at high priority
+    while (g_source_get_ready_time(scheduler) == 0 &&
+           g_source_get_priority(scheduler) == G_PRIORITY_HIGH_IDLE) {
+      g_main_context_iteration(nullptr, false);
+    }
+    if (g_source_get_ready_time(scheduler) == -1) {
+      joined++;
+      continue;
+    }
+    split += g_source_get_priority(scheduler) == G_PRIORITY_LOW;
+
+    // the dispatch at low priority, with whatever GTK had queued before it
+    guint paints = host_paints;
+    while (g_source_get_ready_time(scheduler) == 0) {
+      g_main_context_iteration(nullptr, false);
+    }
+    painted += host_paints != paints;
+    drain_main_loop();
+  }
+
+  g_signal_handlers_disconnect_by_func(clock, (gpointer)on_after_paint,
+                                       nullptr);
+
+  host.cleanup();
+  drain_main_loop();
+  close_plugin(host);
+
+  printf("rounds           %d\n", rounds);
+  printf("save deferred    %d\n", split);
+  printf("save with pass   %d\n", joined);
+  printf("frames before it %d\n", painted);
+
+  if (split + joined == 0) {
+    fprintf(stderr, "nothing was queued; is the window active?\n");
+    return 2;
+  }
+  return joined > 0 || split < rounds ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+  char const *mode = nullptr;
+  int count = 0;
+  int arg = 1;
+
+  if (argc > 2 && strncmp(argv[1], "--", 2) == 0) {
+    mode = argv[1] + 2;
+    count = atoi(argv[2]);
+    arg = 3;
+  }
+  if (arg >= argc) {
+    fprintf(stderr,
+            "usage: %s [--soak seconds | --tabs count | --startup documents "
+            "| --inactive rounds | --switcher documents | --allocs events "
+            "| --scheduler rounds] plugin.so [cycles]\n",
+            argv[0]);
+    return 2;
+  }
+  char const *plugin_fn = argv[arg];
+  int cycles = arg + 1 < argc ? std::max(atoi(argv[arg + 1]), 2) : 1000;
+
+  if (!gtk_init_check(&argc, &argv)) {
+    fprintf(stderr, "cannot open display; run under xvfb-run\n");
+    return 2;
+  }
+
+  setup_host();
+
+  int status;
+  if (mode == nullptr) {
+    status = run_cycles(plugin_fn, cycles);
+  } else if (strcmp(mode, "soak") == 0) {
+    status = run_soak(plugin_fn, std::max(count, 10));
+  } else if (strcmp(mode, "tabs") == 0) {
+    status = run_tabs(plugin_fn, std::max(count, 1));
+  } else if (strcmp(mode, "startup") == 0) {
+    status = run_startup(plugin_fn, std::max(count, 1));
+  } else if (strcmp(mode, "inactive") == 0) {
+    status = run_inactive(plugin_fn, std::max(count, 1));
+  } else if (strcmp(mode, "switcher") == 0) {
+    status = run_switcher(plugin_fn, std::max(count, 1));
+  } else if (strcmp(mode, "allocs") == 0) {
+    status = run_allocs(plugin_fn, std::max(count, 1));
+  } else if (strcmp(mode, "scheduler") == 0) {
+    status = run_scheduler(plugin_fn, std::max(count, 1));
+  } else {
+    fprintf(stderr, "%s: unknown mode --%s\n", argv[0], mode);
+    status = 2;
+  }
+
+  gtk_widget_destroy(host_widgets.window);
+  remove_tree(host_app.configdir);
+
+  return status;
+}
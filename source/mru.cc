@@ -0,0 +1,133 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "mru.h"
+
+// Global Variables
+TweakMru mru;
+
+// Functions
+
+// documents opened in the background have not been used yet
+void TweakMru::add(GeanyDocument *doc) {
+  if (!DOC_VALID(doc)) {
+    return;
+  }
+
+  Node &node = nodes[doc->id];
+  if (node.doc == nullptr) {
+    node.doc = doc;
+    push_back(&node);
+  }
+}
+
+void TweakMru::touch(GeanyDocument *doc) {
+  if (!DOC_VALID(doc) || is_navigating()) {
+    return;
+  }
+
+  Node &node = nodes[doc->id];
+  if (node.doc == nullptr) {
+    node.doc = doc;
+  } else if (head == &node) {
+    return;
+  } else {
+    unlink(&node);
+  }
+  push_front(&node);
+}
+
+void TweakMru::remove(GeanyDocument *doc) {
+  if (doc == nullptr) {
+    return;
+  }
+
+  auto it = nodes.find(doc->id);
+  if (it == nodes.end()) {
+    return;
+  }
+
+  Node *node = &it->second;
+  if (cursor == node) {
+    cursor = node->next != nullptr ? node->next : node->prev;
+  }
+  unlink(node);
+  nodes.erase(it);
+}
+
+void TweakMru::clear() {
+  nodes.clear();
+  head = nullptr;
+  tail = nullptr;
+  cursor = nullptr;
+}
+
+// wraps around at either end
+GeanyDocument *TweakMru::step(gboolean older) {
+  if (head == nullptr) {
+    return nullptr;
+  }
+
+  if (cursor == nullptr) {
+    cursor = head;
+  }
+
+  if (older) {
+    cursor = cursor->next != nullptr ? cursor->next : head;
+  } else {
+    cursor = cursor->prev != nullptr ? cursor->prev : tail;
+  }
+
+  return cursor->doc;
+}
+
+GeanyDocument *TweakMru::commit() {
+  if (cursor == nullptr) {
+    return nullptr;
+  }
+
+  Node *node = cursor;
+  cursor = nullptr;
+
+  if (head != node) {
+    unlink(node);
+    push_front(node);
+  }
+  return node->doc;
+}
+
+void TweakMru::unlink(Node *node) {
+  if (node->prev != nullptr) {
+    node->prev->next = node->next;
+  } else {
+    head = node->next;
+  }
+  if (node->next != nullptr) {
+    node->next->prev = node->prev;
+  } else {
+    tail = node->prev;
+  }
+  node->prev = nullptr;
+  node->next = nullptr;
+}
+
+void TweakMru::push_front(Node *node) {
+  node->prev = nullptr;
+  node->next = head;
+  if (head != nullptr) {
+    head->prev = node;
+  } else {
+    tail = node;
+  }
+  head = node;
+}
+
+void TweakMru::push_back(Node *node) {
+  node->next = nullptr;
+  node->prev = tail;
+  if (tail != nullptr) {
+    tail->next = node;
+  } else {
+    head = node;
+  }
+  tail = node;
+}
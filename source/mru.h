@@ -0,0 +1,44 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <unordered_map>
+
+#include "plugin.h"
+
+// Most recently used documents, newest first.  Nodes are linked in place and
+// indexed by document id, so activation and close are O(1) however many
+// documents are open.
+class TweakMru {
+ public:
+  TweakMru() = default;
+
+  void add(GeanyDocument *doc);
+  void touch(GeanyDocument *doc);
+  void remove(GeanyDocument *doc);
+  void clear();
+
+  // Stepping previews documents without reordering the list; the document
+  // shown last moves to the front on commit.
+  GeanyDocument *step(gboolean older);
+  GeanyDocument *commit();
+  gboolean is_navigating() const { return cursor != nullptr; }
+
+  gsize size() const { return nodes.size(); }
+
+ private:
+  struct Node {
+    GeanyDocument *doc = nullptr;
+    Node *prev = nullptr;
+    Node *next = nullptr;
+  };
+
+  void unlink(Node *node);
+  void push_front(Node *node);
+  void push_back(Node *node);
+
+  std::unordered_map<guint, Node> nodes;
+  Node *head = nullptr;
+  Node *tail = nullptr;
+  Node *cursor = nullptr;
+};
@@ -0,0 +1,315 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "notebooks.h"
+
+#include <algorithm>
+
+#include "trace.h"
+
+// Global Variables
+TweakNotebookRegistry notebooks;
+
+static GQuark notebook_quark() {
+  static GQuark quark = g_quark_from_static_string("xitweaks-notebook");
+  return quark;
+}
+
+struct TweakRebuildState {
+  std::vector<TweakPage> *pages;
+  GtkWidget *action_start;
+  GtkWidget *action_end;
+  gsize next;  // index of the next page expected from forall
+};
+
+static void rebuild_collect_page(GtkWidget *child, gpointer data) {
+  TweakPage page;
+  page.page = child;
+  static_cast<std::vector<TweakPage> *>(data)->push_back(page);
+}
+
+// GtkNotebook's forall yields each page followed by its tab label, if any,
+// then the action widgets.
+static void rebuild_collect_label(GtkWidget *child, gpointer data) {
+  auto *state = static_cast<TweakRebuildState *>(data);
+  std::vector<TweakPage> &pages = *state->pages;
+
+  if (state->next < pages.size() && pages[state->next].page == child) {
+    state->next++;
+  } else if (state->next > 0 && pages[state->next - 1].label == nullptr &&
+             child != state->action_start && child != state->action_end) {
+    pages[state->next - 1].label = child;
+  }
+}
+
+// Functions
+
+TweakNotebook *TweakNotebookRegistry::add(GtkNotebook *notebook,
+                                          TweakNotebookKind kind,
+                                          gboolean *added) {
+  TweakNotebook *entry = find(notebook);
+
+  if (added != nullptr) {
+    *added = entry == nullptr;
+  }
+  if (entry != nullptr) {
+    return entry;
+  }
+
+  entry = new TweakNotebook();
+  entry->notebook = notebook;
+  entry->kind = kind;
+
+  g_object_set_qdata(G_OBJECT(notebook), notebook_quark(), entry);
+  g_object_weak_ref(G_OBJECT(notebook), on_finalized, this);
+
+  notebooks.push_back(entry);
+  mark_dirty(entry);
+
+  return entry;
+}
+
+void TweakNotebookRegistry::remove(GtkNotebook *notebook) {
+  TweakNotebook *entry = find(notebook);
+  if (entry == nullptr) {
+    return;
+  }
+
+  disconnect(entry);
+  g_object_weak_unref(G_OBJECT(notebook), on_finalized, this);
+  g_object_set_qdata(G_OBJECT(notebook), notebook_quark(), nullptr);
+
+  forget(entry);
+}
+
+void TweakNotebookRegistry::clear() {
+  while (!notebooks.empty()) {
+    remove(notebooks.back()->notebook);
+  }
+}
+
+TweakNotebook *TweakNotebookRegistry::find(GtkNotebook *notebook) const {
+  if (notebook == nullptr) {
+    return nullptr;
+  }
+  return static_cast<TweakNotebook *>(
+      g_object_get_qdata(G_OBJECT(notebook), notebook_quark()));
+}
+
+TweakNotebookKind TweakNotebookRegistry::kind_of(GtkNotebook *notebook) const {
+  TweakNotebook *entry = find(notebook);
+  return entry != nullptr ? entry->kind : TWEAKS_NOTEBOOK_OTHER;
+}
+
+void TweakNotebookRegistry::disconnect(TweakNotebook *entry) {
+  for (gulong handler : entry->handlers) {
+    g_signal_handler_disconnect(entry->notebook, handler);
+  }
+  entry->handlers.clear();
+
+  // no longer tracked
+  entry->pages.clear();
+  entry->pages_valid = false;
+}
+
+// Blocks or unblocks the handlers of every notebook in one go.  They stay
+// connected, so disabling highlighting does not touch the signal tables.
+void TweakNotebookRegistry::set_blocked(gboolean block) {
+  if (blocked == block) {
+    return;
+  }
+  blocked = block;
+
+  for (TweakNotebook *entry : notebooks) {
+    for (gulong handler : entry->handlers) {
+      if (block) {
+        g_signal_handler_block(entry->notebook, handler);
+      } else {
+        g_signal_handler_unblock(entry->notebook, handler);
+      }
+    }
+
+    // pages may change while nothing is listening
+    entry->pages.clear();
+    entry->pages_valid = false;
+  }
+}
+
+// gtk_notebook_get_nth_page() and gtk_notebook_get_tab_label() each walk the
+// page list, so looking up every page is quadratic.  Collect pages and
+// labels with two linear container walks instead.
+void notebook_collect_pages(GtkNotebook *nb, std::vector<TweakPage> &pages) {
+  pages.clear();
+  pages.reserve(gtk_notebook_get_n_pages(nb));
+  gtk_container_foreach(GTK_CONTAINER(nb), rebuild_collect_page, &pages);
+
+  TweakRebuildState state = {
+      &pages, gtk_notebook_get_action_widget(nb, GTK_PACK_START),
+      gtk_notebook_get_action_widget(nb, GTK_PACK_END), 0};
+  gtk_container_forall(GTK_CONTAINER(nb), rebuild_collect_label, &state);
+
+  // pages without a label in the walk, if GTK ever changes its order
+  for (TweakPage &page : pages) {
+    if (page.label == nullptr) {
+      page.label = gtk_notebook_get_tab_label(nb, page.page);
+    }
+  }
+}
+
+// The focus page keeps its state, so a reduced pass can still unname it.
+void TweakNotebookRegistry::rebuild_pages(TweakNotebook *entry) {
+  TweakPage focus;
+  int focus_page = entry->focus_page;
+  if (focus_page >= 0 && focus_page < int(entry->pages.size())) {
+    focus = entry->pages[focus_page];
+  }
+  entry->focus_page = -1;
+
+  notebook_collect_pages(entry->notebook, entry->pages);
+  entry->pages_valid = true;
+
+  for (int i = 0; focus.page != nullptr && i < int(entry->pages.size()); i++) {
+    TweakPage &page = entry->pages[i];
+    if (page.page == focus.page) {
+      if (page.label == focus.label) {
+        page.tab_state = focus.tab_state;
+      }
+      page.page_state = focus.page_state;
+      entry->focus_page = i;
+      break;
+    }
+  }
+}
+
+void TweakNotebookRegistry::page_added(TweakNotebook *entry, GtkWidget *child,
+                                       guint page_num) {
+  if (entry == nullptr || !entry->pages_valid) {
+    return;
+  }
+  if (bulk_loading || page_num > entry->pages.size()) {
+    entry->pages_valid = false;
+    return;
+  }
+
+  TweakPage page;
+  page.page = child;
+  page.label = gtk_notebook_get_tab_label(entry->notebook, child);
+  entry->pages.insert(entry->pages.begin() + page_num, page);
+  if (entry->focus_page >= int(page_num)) {
+    entry->focus_page++;
+  }
+}
+
+void TweakNotebookRegistry::page_removed(TweakNotebook *entry,
+                                         GtkWidget *child, guint page_num) {
+  if (entry == nullptr || !entry->pages_valid) {
+    return;
+  }
+  if (page_num >= entry->pages.size() ||
+      entry->pages[page_num].page != child) {
+    entry->pages_valid = false;
+    return;
+  }
+
+  entry->pages.erase(entry->pages.begin() + page_num);
+  if (entry->focus_page == int(page_num)) {
+    entry->focus_page = -1;
+  } else if (entry->focus_page > int(page_num)) {
+    entry->focus_page--;
+  }
+}
+
+void TweakNotebookRegistry::page_reordered(TweakNotebook *entry,
+                                           GtkWidget *child, guint page_num) {
+  if (entry == nullptr || !entry->pages_valid) {
+    return;
+  }
+
+  auto it = std::find_if(
+      entry->pages.begin(), entry->pages.end(),
+      [child](TweakPage const &page) { return page.page == child; });
+  if (it == entry->pages.end() || page_num >= entry->pages.size()) {
+    entry->pages_valid = false;
+    return;
+  }
+
+  int from = it - entry->pages.begin();
+  auto to = entry->pages.begin() + page_num;
+  if (to < it) {
+    std::rotate(to, it, it + 1);
+  } else {
+    std::rotate(it, it + 1, to + 1);
+  }
+
+  int &focus = entry->focus_page;
+  if (focus == from) {
+    focus = page_num;
+  } else if (from < focus && focus <= int(page_num)) {
+    focus--;
+  } else if (int(page_num) <= focus && focus < from) {
+    focus++;
+  }
+}
+
+// GTK does not signal a replaced tab label; its style is written anew.
+void TweakNotebookRegistry::set_tab_label(TweakNotebook *entry,
+                                          GtkWidget *child, GtkWidget *label) {
+  if (entry == nullptr || !entry->pages_valid) {
+    return;
+  }
+
+  for (TweakPage &page : entry->pages) {
+    if (page.page == child) {
+      page.label = label;
+      page.tab_state = TWEAKS_STYLE_UNKNOWN;
+      mark_dirty(entry);
+      break;
+    }
+  }
+}
+
+void TweakNotebookRegistry::mark_dirty(TweakNotebook *entry) {
+  if (entry != nullptr && !entry->dirty) {
+    entry->dirty = true;
+    dirty.push_back(entry);
+  }
+}
+
+void TweakNotebookRegistry::mark_all_dirty() {
+  tracer.record(TWEAKS_TRACE_DIRTY_ALL, TWEAKS_NOTEBOOK_OTHER, 0);
+  for (TweakNotebook *entry : notebooks) {
+    mark_dirty(entry);
+  }
+}
+
+void TweakNotebookRegistry::clear_dirty() {
+  for (TweakNotebook *entry : dirty) {
+    entry->dirty = false;
+  }
+  dirty.clear();
+}
+
+// The notebook is gone, and its signal handlers with it.
+void TweakNotebookRegistry::on_finalized(gpointer data,
+                                         GObject *where_the_object_was) {
+  auto *self = static_cast<TweakNotebookRegistry *>(data);
+
+  for (TweakNotebook *entry : self->notebooks) {
+    if (G_OBJECT(entry->notebook) == where_the_object_was) {
+      entry->handlers.clear();
+      self->forget(entry);
+      break;
+    }
+  }
+}
+
+void TweakNotebookRegistry::forget(TweakNotebook *entry) {
+  notebooks.erase(std::remove(notebooks.begin(), notebooks.end(), entry),
+                  notebooks.end());
+  dirty.erase(std::remove(dirty.begin(), dirty.end(), entry), dirty.end());
+
+  if (focused == entry) {
+    focused = nullptr;
+  }
+
+  delete entry;
+}
@@ -0,0 +1,105 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <vector>
+
+#include "plugin.h"
+
+enum TweakNotebookKind {
+  TWEAKS_NOTEBOOK_SIDEBAR,
+  TWEAKS_NOTEBOOK_MSGWIN,
+  TWEAKS_NOTEBOOK_EDITOR,
+  TWEAKS_NOTEBOOK_OTHER,  // split views, plugin panels, detached windows
+};
+
+enum TweakNotebookPolicy {
+  TWEAKS_POLICY_NONE = 0,
+  TWEAKS_POLICY_TAB = 1 << 0,   // style the tab label of the focused page
+  TWEAKS_POLICY_PAGE = 1 << 1,  // style the focused page itself
+};
+
+// style last written to a tab label or page
+enum TweakStyleState {
+  TWEAKS_STYLE_UNKNOWN,
+  TWEAKS_STYLE_UNFOCUS,
+  TWEAKS_STYLE_FOCUS,
+};
+
+struct TweakPage {
+  GtkWidget *page = nullptr;
+  GtkWidget *label = nullptr;
+  guint8 tab_state = TWEAKS_STYLE_UNKNOWN;
+  guint8 page_state = TWEAKS_STYLE_UNKNOWN;
+};
+
+struct TweakNotebook {
+  GtkNotebook *notebook = nullptr;
+  TweakNotebookKind kind = TWEAKS_NOTEBOOK_OTHER;
+  guint policy = TWEAKS_POLICY_NONE;
+  gboolean dirty = false;
+  gboolean focused = false;
+  std::vector<gulong> handlers;
+
+  // Pages in notebook order, kept in step with page-added, page-removed,
+  // and page-reordered so a pass never walks the notebook's own list.
+  std::vector<TweakPage> pages;
+  gboolean pages_valid = false;
+
+  // page whose tab or page is named as focused, or -1; at most one is
+  int focus_page = -1;
+};
+
+void notebook_collect_pages(GtkNotebook *nb, std::vector<TweakPage> &pages);
+
+class TweakNotebookRegistry {
+ public:
+  TweakNotebookRegistry() = default;
+  ~TweakNotebookRegistry() { clear(); }
+
+  TweakNotebook *add(GtkNotebook *notebook, TweakNotebookKind kind,
+                     gboolean *added = nullptr);
+  void remove(GtkNotebook *notebook);
+  void clear();
+  TweakNotebook *find(GtkNotebook *notebook) const;
+  TweakNotebookKind kind_of(GtkNotebook *notebook) const;
+
+  void disconnect(TweakNotebook *entry);
+  void set_blocked(gboolean block);
+
+  void rebuild_pages(TweakNotebook *entry);
+  void page_added(TweakNotebook *entry, GtkWidget *child, guint page_num);
+  void page_removed(TweakNotebook *entry, GtkWidget *child, guint page_num);
+  void page_reordered(TweakNotebook *entry, GtkWidget *child,
+                      guint page_num);
+  void set_tab_label(TweakNotebook *entry, GtkWidget *child,
+                     GtkWidget *label);
+
+  // While bulk loading (session restore, project open), page-added only
+  // invalidates the page vector; one rebuild follows when loading ends.
+  void begin_bulk_load() { bulk_loading = true; }
+  void end_bulk_load() { bulk_loading = false; }
+  gboolean is_bulk_loading() const { return bulk_loading; }
+
+  void mark_dirty(TweakNotebook *entry);
+  void mark_all_dirty();
+  void clear_dirty();
+
+  std::vector<TweakNotebook *> const &get_notebooks() const {
+    return notebooks;
+  }
+  std::vector<TweakNotebook *> const &get_dirty() const { return dirty; }
+
+ public:
+  // notebook that had focus after the last highlight pass
+  TweakNotebook *focused = nullptr;
+
+ private:
+  static void on_finalized(gpointer data, GObject *where_the_object_was);
+  void forget(TweakNotebook *entry);
+
+  std::vector<TweakNotebook *> notebooks;
+  std::vector<TweakNotebook *> dirty;
+  gboolean bulk_loading = false;
+  gboolean blocked = false;
+};
@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "overlay.h"
+
+#include "prefs.h"
+#include "tabrules.h"
+
+// Global Variables
+TweakProjectOverlay overlay;
+
+static struct {
+  char const *key;
+  gboolean TweakSettings::*member;
+  guint change;
+} const overlay_keys[] = {
+    {"sidebar_focus_enabled", &TweakSettings::sidebar_focus_enabled,
+     TWEAKS_CHANGE_FOCUS},
+    {"notebook_focus_enabled", &TweakSettings::notebook_focus_enabled,
+     TWEAKS_CHANGE_FOCUS},
+    {"inactive_window_dimmed", &TweakSettings::inactive_window_dimmed,
+     TWEAKS_CHANGE_WINDOW},
+    {"doc_state_enabled", &TweakSettings::doc_state_enabled,
+     TWEAKS_CHANGE_DOC_STATE},
+    {"tab_activity_enabled", &TweakSettings::tab_activity_enabled,
+     TWEAKS_CHANGE_ACTIVITY},
+    {"adaptive_quality_enabled", &TweakSettings::adaptive_quality_enabled,
+     TWEAKS_CHANGE_QUALITY},
+    {"pane_autoresize_enabled", &TweakSettings::pane_autoresize_enabled,
+     TWEAKS_CHANGE_PANES | TWEAKS_CHANGE_FOCUS},
+    {"compact_tabs_enabled", &TweakSettings::compact_tabs_enabled,
+     TWEAKS_CHANGE_COMPACT},
+};
+
+static_assert(G_N_ELEMENTS(overlay_keys) == TWEAKS_OVERLAY_KEYS,
+              "TWEAKS_OVERLAY_KEYS does not match overlay_keys");
+
+// Functions
+
+// Returns the changes to re-apply.  Passing nullptr removes the overlay.
+guint TweakProjectOverlay::open(GKeyFile *config) {
+  gboolean before[TWEAKS_OVERLAY_KEYS];
+  snapshot(before);
+
+  restore();
+  for (int i = 0; i < TWEAKS_OVERLAY_KEYS; i++) {
+    has[i] = config != nullptr &&
+             g_key_file_has_key(config, TWEAKS_PROJECT_GROUP,
+                                overlay_keys[i].key, nullptr);
+    if (has[i]) {
+      value[i] = g_key_file_get_boolean(config, TWEAKS_PROJECT_GROUP,
+                                        overlay_keys[i].key, nullptr);
+    }
+  }
+  apply();
+
+  guint changes = diff(before);
+  if (tabrules.set_project_rules(config, TWEAKS_PROJECT_GROUP)) {
+    changes |= TWEAKS_CHANGE_DOC_STATE;
+  }
+  return changes;
+}
+
+guint TweakProjectOverlay::close() { return open(nullptr); }
+
+void TweakProjectOverlay::apply() {
+  if (applied) {
+    return;
+  }
+
+  for (int i = 0; i < TWEAKS_OVERLAY_KEYS; i++) {
+    if (has[i]) {
+      base[i] = settings.*overlay_keys[i].member;
+      settings.*overlay_keys[i].member = value[i];
+    }
+  }
+  applied = true;
+}
+
+void TweakProjectOverlay::restore() {
+  if (!applied) {
+    return;
+  }
+
+  for (int i = 0; i < TWEAKS_OVERLAY_KEYS; i++) {
+    if (has[i]) {
+      settings.*overlay_keys[i].member = base[i];
+    }
+  }
+  applied = false;
+}
+
+// settings were just read from the config file
+void TweakProjectOverlay::reapply() {
+  applied = false;
+  apply();
+}
+
+guint TweakProjectOverlay::diff(gboolean const *before) const {
+  guint changes = TWEAKS_CHANGE_NONE;
+
+  for (int i = 0; i < TWEAKS_OVERLAY_KEYS; i++) {
+    if (before[i] != settings.*overlay_keys[i].member) {
+      changes |= overlay_keys[i].change;
+    }
+  }
+  return changes;
+}
+
+void TweakProjectOverlay::snapshot(gboolean *values) const {
+  for (int i = 0; i < TWEAKS_OVERLAY_KEYS; i++) {
+    values[i] = settings.*overlay_keys[i].member;
+  }
+}
@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "plugin.h"
+
+#define TWEAKS_PROJECT_GROUP "xitweaks"
+
+// what has to be re-applied after settings change
+enum TweakSettingChange {
+  TWEAKS_CHANGE_NONE = 0,
+  TWEAKS_CHANGE_FOCUS = 1 << 0,      // notebook focus highlighting
+  TWEAKS_CHANGE_WINDOW = 1 << 1,     // inactive window dimming
+  TWEAKS_CHANGE_DOC_STATE = 1 << 2,  // document state and tab style rules
+  TWEAKS_CHANGE_ACTIVITY = 1 << 3,   // sidebar and msgwin activity marks
+  TWEAKS_CHANGE_COMPACT = 1 << 4,    // compact editor tab labels
+  TWEAKS_CHANGE_QUALITY = 1 << 5,    // adaptive highlight quality
+  TWEAKS_CHANGE_PANES = 1 << 6,      // sidebar and msgwin auto-resize
+
+  TWEAKS_CHANGE_ALL = (1 << 7) - 1,
+};
+
+#define TWEAKS_OVERLAY_KEYS 8
+
+// Settings overridden by the [xitweaks] group of the open project.  The
+// group is read from the keyfile Geany passes to project-open, so switching
+// projects needs no disk access.  Overridden settings keep their values
+// from the config file, so those are what gets saved.
+class TweakProjectOverlay {
+ public:
+  TweakProjectOverlay() = default;
+
+  guint open(GKeyFile *config);
+  guint close();
+
+  void apply();
+  void restore();
+  void reapply();
+
+ private:
+  guint diff(gboolean const *before) const;
+  void snapshot(gboolean *values) const;
+
+  gboolean has[TWEAKS_OVERLAY_KEYS] = {};
+  gboolean value[TWEAKS_OVERLAY_KEYS] = {};
+  gboolean base[TWEAKS_OVERLAY_KEYS] = {};
+  gboolean applied = false;
+};
@@ -0,0 +1,168 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "paneresize.h"
+
+#define TWEAKS_PANE_ANIMATION_US 150000
+
+// Global Variables
+TweakPaneResize paneresize;
+
+// Functions
+
+void TweakPaneResize::setup(GtkWidget *hpane, GtkWidget *vpane,
+                            GtkWidget *sidebar_nb, GtkWidget *msgwin_nb) {
+  clear();
+  init_pane(sidebar, hpane, sidebar_nb);
+  init_pane(msgwin, vpane, msgwin_nb);
+}
+
+void TweakPaneResize::configure(gboolean enable, gint width, gint height) {
+  enabled = enable;
+  sidebar_width = width;
+  msgwin_height = height;
+
+  if (!enabled) {
+    restore(sidebar);
+    restore(msgwin);
+  }
+}
+
+// Called after every highlight pass.  Focus elsewhere, such as in a
+// plugin panel, leaves the panes as they are.
+void TweakPaneResize::update(TweakNotebookKind focused) {
+  if (!enabled) {
+    return;
+  }
+
+  switch (focused) {
+    case TWEAKS_NOTEBOOK_SIDEBAR:
+      widen(sidebar, sidebar_width);
+      restore(msgwin);
+      break;
+    case TWEAKS_NOTEBOOK_MSGWIN:
+      widen(msgwin, msgwin_height);
+      restore(sidebar);
+      break;
+    case TWEAKS_NOTEBOOK_EDITOR:
+      restore(sidebar);
+      restore(msgwin);
+      break;
+    default:
+      break;
+  }
+}
+
+// Jumps back to the saved positions without animating, since the plugin
+// may be about to unload.  A restore in flight jumps to where it ends.
+void TweakPaneResize::clear() {
+  for (TweakPane *pane : {&sidebar, &msgwin}) {
+    gint position = pane->saved >= 0    ? pane->saved
+                    : pane->tick_id != 0 ? pane->to
+                                         : -1;
+    stop(*pane);
+    if (pane->paned != nullptr && position >= 0) {
+      gtk_paned_set_position(pane->paned, position);
+    }
+    pane->saved = -1;
+  }
+}
+
+void TweakPaneResize::init_pane(TweakPane &pane, GtkWidget *paned,
+                                GtkWidget *notebook) {
+  pane = TweakPane();
+  if (paned == nullptr || !GTK_IS_PANED(paned)) {
+    return;
+  }
+
+  GtkWidget *child1 = gtk_paned_get_child1(GTK_PANED(paned));
+  pane.paned = GTK_PANED(paned);
+  pane.notebook = notebook;
+  pane.first = child1 == notebook ||
+               (child1 != nullptr && gtk_widget_is_ancestor(notebook, child1));
+}
+
+gint TweakPaneResize::get_extent(TweakPane const &pane) {
+  GtkWidget *widget = GTK_WIDGET(pane.paned);
+  return gtk_orientable_get_orientation(GTK_ORIENTABLE(widget)) ==
+                 GTK_ORIENTATION_HORIZONTAL
+             ? gtk_widget_get_allocated_width(widget)
+             : gtk_widget_get_allocated_height(widget);
+}
+
+// A pane already as large as the target keeps its size.  During a
+// restore, the size it is restored to counts, not the one on screen.
+void TweakPaneResize::widen(TweakPane &pane, gint size) {
+  if (pane.paned == nullptr || !gtk_widget_get_visible(pane.notebook) ||
+      pane.saved >= 0) {
+    return;
+  }
+
+  gint extent = get_extent(pane);
+  gint position =
+      pane.tick_id != 0 ? pane.to : gtk_paned_get_position(pane.paned);
+  gint current = pane.first ? position : extent - position;
+  if (current >= size || size >= extent) {
+    return;
+  }
+
+  pane.saved = position;
+  animate_to(pane, pane.first ? size : extent - size);
+}
+
+// A pane the user resized while it was widened stays where they put it.
+void TweakPaneResize::restore(TweakPane &pane) {
+  if (pane.paned == nullptr || pane.saved < 0) {
+    return;
+  }
+
+  gint saved = pane.saved;
+  pane.saved = -1;
+
+  if (pane.tick_id == 0 && gtk_paned_get_position(pane.paned) != pane.to) {
+    return;
+  }
+  animate_to(pane, saved);
+}
+
+// Restarts from the current position if an animation is running.
+void TweakPaneResize::animate_to(TweakPane &pane, gint position) {
+  pane.from = gtk_paned_get_position(pane.paned);
+  pane.to = position;
+  pane.start_time = 0;
+
+  if (pane.tick_id == 0) {
+    pane.tick_id = gtk_widget_add_tick_callback(GTK_WIDGET(pane.paned),
+                                                on_tick, &pane, nullptr);
+  }
+}
+
+void TweakPaneResize::stop(TweakPane &pane) {
+  if (pane.tick_id != 0) {
+    gtk_widget_remove_tick_callback(GTK_WIDGET(pane.paned), pane.tick_id);
+    pane.tick_id = 0;
+  }
+}
+
+// One position per frame, eased out, set before the frame's layout.
+gboolean TweakPaneResize::on_tick(GtkWidget *widget, GdkFrameClock *clock,
+                                  gpointer user_data) {
+  auto *pane = static_cast<TweakPane *>(user_data);
+  gint64 now = gdk_frame_clock_get_frame_time(clock);
+  if (pane->start_time == 0) {
+    pane->start_time = now;
+  }
+
+  double t = double(now - pane->start_time) / TWEAKS_PANE_ANIMATION_US;
+  if (t >= 1.0) {
+    gtk_paned_set_position(pane->paned, pane->to);
+    pane->tick_id = 0;
+    return G_SOURCE_REMOVE;
+  }
+
+  double eased = 1.0 - (1.0 - t) * (1.0 - t) * (1.0 - t);
+  gint position = pane->from + gint((pane->to - pane->from) * eased);
+  if (position != gtk_paned_get_position(pane->paned)) {
+    gtk_paned_set_position(pane->paned, position);
+  }
+  return G_SOURCE_CONTINUE;
+}
@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "notebooks.h"
+#include "plugin.h"
+
+// one side of a paned holding the sidebar or message window
+struct TweakPane {
+  GtkPaned *paned = nullptr;
+  GtkWidget *notebook = nullptr;
+  gboolean first = true;  // the notebook is in child1
+
+  gint saved = -1;  // position before widening, -1 when not widened
+
+  // animation from one position to another
+  gint from = 0;
+  gint to = 0;
+  gint64 start_time = 0;  // frame time of the first step, 0 until then
+  guint tick_id = 0;
+};
+
+// Widens the sidebar or message window while it has focus and restores it
+// when focus returns to the editor.  Positions change only in tick
+// callbacks, so the editor is allocated at most once per frame, and the
+// callback is removed as soon as the animation ends.
+class TweakPaneResize {
+ public:
+  TweakPaneResize() = default;
+
+  void setup(GtkWidget *hpane, GtkWidget *vpane, GtkWidget *sidebar_nb,
+             GtkWidget *msgwin_nb);
+  void configure(gboolean enable, gint width, gint height);
+  void update(TweakNotebookKind focused);
+  void clear();
+
+ private:
+  static void init_pane(TweakPane &pane, GtkWidget *paned,
+                        GtkWidget *notebook);
+  static gint get_extent(TweakPane const &pane);
+  static void widen(TweakPane &pane, gint size);
+  static void restore(TweakPane &pane);
+  static void animate_to(TweakPane &pane, gint position);
+  static void stop(TweakPane &pane);
+  static gboolean on_tick(GtkWidget *widget, GdkFrameClock *clock,
+                          gpointer user_data);
+
+  TweakPane sidebar;
+  TweakPane msgwin;
+  gboolean enabled = false;
+  gint sidebar_width = 0;
+  gint msgwin_height = 0;
+};
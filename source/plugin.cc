@@ -1,31 +1,46 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
-#ifndef DEBUG
-#define DEBUG_STATUS_1(arg)                                    \
-  do {                                                         \
-    std::string _nb;                                           \
-    if (arg == geany_sidebar) {                                \
-      _nb = "sidebar";                                         \
-    } else if (arg == geany_msgwin) {                          \
-      _nb = "msgwin";                                          \
-    } else if (arg == geany_editor) {                          \
-      _nb = "editor";                                          \
-    } else {                                                   \
-      _nb = "unknown";                                         \
-    }                                                          \
-    msgwin_status_add(_("%s: %s"), _nb.c_str(), __FUNCTION__); \
+#ifdef DEBUG
+#define DEBUG_STATUS_1(arg)                                \
+  do {                                                     \
+    char const *_nb;                                       \
+    if (arg == geany_sidebar) {                            \
+      _nb = "sidebar";                                     \
+    } else if (arg == geany_msgwin) {                      \
+      _nb = "msgwin";                                      \
+    } else if (arg == geany_editor) {                      \
+      _nb = "editor";                                      \
+    } else {                                               \
+      _nb = "unknown";                                     \
+    }                                                      \
+    msgwin_status_add(_("%s: %s"), _nb, __FUNCTION__);     \
   } while (0)
 #define DEBUG_STATUS_0() msgwin_status_add(_("%s"), __FUNCTION__)
 #else
-#define DEBUG_STATUS_1()
+#define DEBUG_STATUS_1(arg)
 #define DEBUG_STATUS_0()
 #endif
 
 #include <time.h>
 
+#include "activity.h"
 #include "auxiliary.h"
+#include "compacttabs.h"
+#include "counters.h"
+#include "docstate.h"
+#include "focusservice.h"
+#include "latency.h"
+#include "mru.h"
+#include "notebooks.h"
+#include "overlay.h"
+#include "paneresize.h"
 #include "plugin.h"
 #include "prefs.h"
+#include "probes.h"
+#include "quality.h"
+#include "scheduler.h"
+#include "switcher.h"
+#include "trace.h"
 
 /* ********************
  * Globals
@@ -38,32 +53,61 @@ static GtkNotebook *geany_sidebar = nullptr;
 static GtkNotebook *geany_msgwin = nullptr;
 static GtkNotebook *geany_editor = nullptr;
 static GtkWidget *geany_hpane = nullptr;
+static GtkWidget *geany_vpane = nullptr;
 
 GtkWidget *g_tweaks_menu = nullptr;
 static GeanyDocument *g_current_doc = nullptr;
 
-static gulong g_handle_focus_editor = 0;
-static gulong g_handle_focus_msgwin = 0;
-static gulong g_handle_focus_sidebar = 0;
-static gulong g_handle_grab_focus_editor = 0;
-static gulong g_handle_grab_focus_msgwin = 0;
-static gulong g_handle_grab_focus_sidebar = 0;
-static gulong g_handle_grab_notify_editor = 0;
-static gulong g_handle_grab_notify_msgwin = 0;
-static gulong g_handle_grab_notify_sidebar = 0;
-static gulong g_handle_set_focus_child_editor = 0;
-static gulong g_handle_set_focus_child_msgwin = 0;
-static gulong g_handle_set_focus_child_sidebar = 0;
-static gulong g_handle_switch_page_editor = 0;
-static gulong g_handle_switch_page_msgwin = 0;
-static gulong g_handle_switch_page_sidebar = 0;
-
-static gulong g_handle_notebook_focus_highlight = 0;
-
-static gulong g_handle_reload_config = 0;
+static gboolean g_notebook_focus_enabled = false;
+static guint g_set_focus_signal = 0;
+static gulong g_handle_set_focus_hook = 0;
+
+static gboolean g_window_active = true;
+static gulong g_handle_window_active = 0;
+static gulong g_handle_mru_key_release = 0;
+
+static TweaksFocusService *g_focus_service = nullptr;
 
 static GeanyKeyGroup *gKeyGroup = nullptr;
 
+// toggled in the preferences since the settings were last saved
+static gboolean g_settings_unsaved = false;
+
+// Preference toggles, each with the changes it has to re-apply.  Pane
+// resizing needs focus tracking, which may have to start or stop.
+static struct {
+  gboolean TweakSettings::*member;
+  guint change;
+  char const *label;
+  char const *tooltip;
+} const pref_toggles[] = {
+    {&TweakSettings::sidebar_focus_enabled, TWEAKS_CHANGE_FOCUS,
+     "Highlight the sidebar tab that has focus",
+     "Style with #geany-xitweaks-notebook-tab-focus in geany.css."},
+    {&TweakSettings::notebook_focus_enabled, TWEAKS_CHANGE_FOCUS,
+     "Highlight the focused tab in every notebook",
+     "Sidebar, message window, editor, and plugin notebooks."},
+    {&TweakSettings::inactive_window_dimmed, TWEAKS_CHANGE_WINDOW,
+     "Dim focus styles while the window is inactive",
+     "Adds the class xitweaks-inactive to the main window."},
+    {&TweakSettings::doc_state_enabled, TWEAKS_CHANGE_DOC_STATE,
+     "Style editor tabs by document state",
+     "Modified, read-only, outside the project, and file type classes."},
+    {&TweakSettings::tab_activity_enabled, TWEAKS_CHANGE_ACTIVITY,
+     "Mark sidebar and message window tabs with unseen output",
+     "Adds the class xitweaks-activity until the tab is shown."},
+    {&TweakSettings::adaptive_quality_enabled, TWEAKS_CHANGE_QUALITY,
+     "Reduce highlighting when it is slow",
+     "Steps down when highlighting takes longer than highlight_budget_us."},
+    {&TweakSettings::pane_autoresize_enabled,
+     TWEAKS_CHANGE_PANES | TWEAKS_CHANGE_FOCUS,
+     "Widen the sidebar or message window while it has focus",
+     "Sizes are set by sidebar_focus_width and msgwin_focus_height."},
+    {&TweakSettings::compact_tabs_enabled, TWEAKS_CHANGE_COMPACT,
+     "Compact editor tab labels",
+     "One drawn widget per tab.  Middle-click a tab to close it."},
+};
+
 /* ********************
  * Plugin Setup
  */
@@ -75,12 +119,15 @@ PLUGIN_SET_INFO("Xi/Tweaks", "Miscellaneous tweaks for Geany.", "0.01.0",
 void plugin_init(GeanyData *data) {
   GEANY_PSC("geany-startup-complete", on_startup_signal);
   GEANY_PSC("editor-notify", on_editor_notify);
-  GEANY_PSC("document-activate", on_document_signal);
+  GEANY_PSC("document-activate", on_document_activate_signal);
+  GEANY_PSC("document-close", on_document_close_signal);
   GEANY_PSC("document-new", on_document_signal);
   GEANY_PSC("document-open", on_document_signal);
   GEANY_PSC("document-reload", on_document_signal);
-  GEANY_PSC("project-open", on_project_signal);
-  GEANY_PSC("project-close", on_project_signal);
+  GEANY_PSC("document-save", on_document_signal);
+  GEANY_PSC("document-filetype-set", on_document_filetype_signal);
+  GEANY_PSC("project-open", on_project_open_signal);
+  GEANY_PSC("project-close", on_project_close_signal);
   GEANY_PSC("project-save", on_project_signal);
 
   tweaks_init(geany_plugin, geany_data);
@@ -104,8 +151,35 @@ gboolean tweaks_init(GeanyPlugin *plugin, gpointer data) {
   geany_msgwin = GTK_NOTEBOOK(geany->main_widgets->message_window_notebook);
   geany_editor = GTK_NOTEBOOK(geany->main_widgets->notebook);
   geany_hpane = ui_lookup_widget(GTK_WIDGET(geany_window), "hpaned1");
+  geany_vpane = ui_lookup_widget(GTK_WIDGET(geany_window), "vpaned1");
+
+  // other notebooks are registered when they first take focus
+  notebooks.add(geany_sidebar, TWEAKS_NOTEBOOK_SIDEBAR);
+  notebooks.add(geany_msgwin, TWEAKS_NOTEBOOK_MSGWIN);
+  notebooks.add(geany_editor, TWEAKS_NOTEBOOK_EDITOR);
+  paneresize.setup(geany_hpane, geany_vpane, GTK_WIDGET(geany_sidebar),
+                   GTK_WIDGET(geany_msgwin));
+
+  // other plugins may hold signal handlers on the service, so the type
+  // has to stay registered after unloading
+  plugin_module_make_resident(geany_plugin);
+  g_focus_service = tweaks_focus_service_new();
+  g_object_set_data_full(G_OBJECT(geany_window), XITWEAKS_FOCUS_SERVICE_KEY,
+                         g_focus_service, g_object_unref);
+
+  // loaded at startup, before the session is restored
+  if (!main_is_realized()) {
+    notebook_bulk_load_begin();
+  }
 
   settings.open();
+  latency.open(g_getenv("XITWEAKS_LATENCY_FILE"));
+
+  // not yet shown at startup; the first activation will be noticed
+  g_window_active = !main_is_realized() || gtk_window_is_active(geany_window);
+  g_handle_window_active =
+      g_signal_connect(geany_window, "notify::is-active",
+                       G_CALLBACK(window_active_notify), nullptr);
 
   // set up menu
   GtkWidget *item;
@@ -130,6 +204,10 @@ gboolean tweaks_init(GeanyPlugin *plugin, gpointer data) {
                    nullptr);
   gtk_menu_shell_append(GTK_MENU_SHELL(submenu), item);
 
+  item = gtk_menu_item_new_with_label("Dump Event Trace");
+  g_signal_connect(item, "activate", G_CALLBACK(on_menu_dump_trace), nullptr);
+  gtk_menu_shell_append(GTK_MENU_SHELL(submenu), item);
+
   item = gtk_separator_menu_item_new();
   gtk_menu_shell_append(GTK_MENU_SHELL(submenu), item);
 
@@ -150,30 +228,133 @@ gboolean tweaks_init(GeanyPlugin *plugin, gpointer data) {
       gKeyGroup, TWEAKS_KEY_SWITCH_FOCUS_EDITOR_SIDEBAR_MSGWIN, nullptr, 0,
       GdkModifierType(0), "xitweaks_switch_focus_editor_sidebar_msgwin",
       _("Switch focus among editor, sidebar, and message window."), nullptr);
-
-  if (g_handle_reload_config == 0) {
-    g_handle_reload_config = 1;
-    g_idle_add(reload_config, nullptr);
+  keybindings_set_item(gKeyGroup, TWEAKS_KEY_MRU_OLDER, nullptr, 0,
+                       GdkModifierType(0), "xitweaks_mru_older",
+                       _("Switch to the previously used document."), nullptr);
+  keybindings_set_item(gKeyGroup, TWEAKS_KEY_MRU_NEWER, nullptr, 0,
+                       GdkModifierType(0), "xitweaks_mru_newer",
+                       _("Switch to the next more recently used document."),
+                       nullptr);
+  keybindings_set_item(
+      gKeyGroup, TWEAKS_KEY_QUICK_SWITCHER, nullptr, 0, GdkModifierType(0),
+      "xitweaks_quick_switcher",
+      _("Search open documents, sidebar pages, and message window tabs."),
+      nullptr);
+
+  // documents already open when loaded from the plugin manager
+  if (main_is_realized()) {
+    guint i = 0;
+    foreach_document(i) {
+      mru.add(documents[i]);
+      switcher.add_document(documents[i]);
+    }
+    mru.touch(document_get_current());
+
+    // the project is only on disk when it was opened before the plugin
+    GeanyProject *project = geany_data->app->project;
+    if (project != nullptr) {
+      GKeyFile *kf = g_key_file_new();
+      if (g_key_file_load_from_file(kf, project->file_name, G_KEY_FILE_NONE,
+                                    nullptr)) {
+        overlay.open(kf);
+      }
+      GKEY_FILE_FREE(kf);
+      docstates.set_project(project);
+    }
   }
 
+  scheduler.add(TWEAKS_TASK_RELOAD_CONFIG, TWEAKS_PRIORITY_DEFAULT,
+                reload_config);
+
   return true;
 }
 
 void tweaks_cleanup(GeanyPlugin *plugin, gpointer data) {
   gtk_widget_destroy(g_tweaks_menu);
 
+  mru_commit();
+  mru.clear();
+  switcher.clear();
+
+  g_signal_handler_disconnect(geany_window, g_handle_window_active);
+  g_handle_window_active = 0;
+  g_window_active = true;
+  window_active_update();
+
+  // listeners see focus go away before the service does
   notebook_focus_update(false);
+  tweaks_focus_service_update(g_focus_service, XITWEAKS_FOCUS_NONE, nullptr,
+                              nullptr);
+  g_object_set_data(G_OBJECT(geany_window), XITWEAKS_FOCUS_SERVICE_KEY,
+                    nullptr);
+  g_focus_service = nullptr;
+
+  paneresize.clear();
+  notebooks.clear();
+  docstates.clear_all();
+  compacttabs.clear();
+  activity.clear();
+
+  // The module is resident, so globals outlive the plugin.  The project
+  // may be closed before it is loaded again.
+  overlay.close();
+  docstates.clear_project();
+  quality = TweakQuality();
 
   settings.save();
+
+  // read by tools/idle-wakeups.sh
+  char const *stats_fn = g_getenv("XITWEAKS_STATS_FILE");
+  if (stats_fn != nullptr) {
+    counters.export_to(stats_fn);
+  }
+  latency.close();
+
+  // pending callbacks must not outlive the plugin
+  scheduler.cancel_all();
 }
 
 GtkWidget *tweaks_configure(GeanyPlugin *plugin, GtkDialog *dialog,
                                    gpointer pdata) {
+  GtkWidget *notebook = gtk_notebook_new();
+
+  gtk_notebook_append_page(GTK_NOTEBOOK(notebook),
+                           tweaks_configure_config(dialog),
+                           gtk_label_new("Config"));
+  gtk_notebook_append_page(GTK_NOTEBOOK(notebook),
+                           tweaks_configure_stats(dialog),
+                           gtk_label_new("Statistics"));
+
+  return notebook;
+}
+
+GtkWidget *tweaks_configure_config(GtkDialog *dialog) {
   GtkWidget *box, *btn;
   char *tooltip;
 
   box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 6);
 
+  // the config file values, not those the open project overrides
+  overlay.restore();
+  for (int i = 0; i < int(G_N_ELEMENTS(pref_toggles)); i++) {
+    btn = gtk_check_button_new_with_label(pref_toggles[i].label);
+    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(btn),
+                                 settings.*pref_toggles[i].member);
+    g_signal_connect(btn, "toggled", G_CALLBACK(on_pref_toggled),
+                     GINT_TO_POINTER(i));
+    gtk_box_pack_start(GTK_BOX(box), btn, false, false, 0);
+    gtk_widget_set_tooltip_text(btn, pref_toggles[i].tooltip);
+  }
+  overlay.apply();
+
+  // toggles are saved together once the dialog closes
+  g_signal_connect(box, "destroy", G_CALLBACK(on_pref_config_destroy),
+                   nullptr);
+
+  gtk_box_pack_start(GTK_BOX(box),
+                     gtk_separator_new(GTK_ORIENTATION_HORIZONTAL), false,
+                     false, 3);
+
   tooltip = g_strdup("Save the active settings to the config file.");
   btn = gtk_button_new_with_label("Save Config");
   g_signal_connect(btn, "clicked", G_CALLBACK(on_pref_save_config), dialog);
@@ -219,29 +400,132 @@ GtkWidget *tweaks_configure(GeanyPlugin *plugin, GtkDialog *dialog,
   return box;
 }
 
+GtkWidget *tweaks_configure_stats(GtkDialog *dialog) {
+  GtkWidget *box, *hbox, *scroll, *view, *btn;
+
+  box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 6);
+
+  view = gtk_text_view_new();
+  gtk_text_view_set_editable(GTK_TEXT_VIEW(view), false);
+  gtk_text_view_set_cursor_visible(GTK_TEXT_VIEW(view), false);
+  gtk_text_view_set_monospace(GTK_TEXT_VIEW(view), true);
+
+  scroll = gtk_scrolled_window_new(nullptr, nullptr);
+  gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scroll),
+                                 GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+  gtk_widget_set_size_request(scroll, -1, 320);
+  gtk_container_add(GTK_CONTAINER(scroll), view);
+  gtk_box_pack_start(GTK_BOX(box), scroll, true, true, 3);
+
+  hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 6);
+  gtk_box_pack_start(GTK_BOX(box), hbox, false, false, 3);
+
+  btn = gtk_button_new_with_label("Refresh");
+  g_signal_connect(btn, "clicked", G_CALLBACK(on_stats_refresh), view);
+  gtk_box_pack_start(GTK_BOX(hbox), btn, false, false, 3);
+
+  btn = gtk_button_new_with_label("Reset");
+  g_signal_connect(btn, "clicked", G_CALLBACK(on_stats_reset), view);
+  gtk_box_pack_start(GTK_BOX(hbox), btn, false, false, 3);
+
+  btn = gtk_button_new_with_label("Export...");
+  g_signal_connect(btn, "clicked", G_CALLBACK(on_stats_export), dialog);
+  gtk_box_pack_start(GTK_BOX(hbox), btn, false, false, 3);
+
+  // refresh whenever the page is shown
+  g_signal_connect(view, "map", G_CALLBACK(on_stats_refresh), view);
+
+  return box;
+}
+
 /* ********************
  * Preferences Callbacks
  */
 
 gboolean reload_config(gpointer user_data) {
+  TWEAKS_PROBE_SCOPE(reload_config);
+
   settings.open();
+  settings_apply_changes(TWEAKS_CHANGE_ALL);
+
+  return false;
+}
+
+void settings_apply_changes(guint changes) {
+  if (changes & TWEAKS_CHANGE_WINDOW) {
+    window_active_update();
+  }
+  if (changes & TWEAKS_CHANGE_QUALITY) {
+    quality.configure(settings.adaptive_quality_enabled,
+                      settings.highlight_budget_us);
+  }
+  if (changes & TWEAKS_CHANGE_PANES) {
+    paneresize.configure(settings.pane_autoresize_enabled,
+                         settings.sidebar_focus_width,
+                         settings.msgwin_focus_height);
+  }
+  if (changes & TWEAKS_CHANGE_FOCUS) {
+    notebook_focus_update(
+        settings.sidebar_focus_enabled || settings.notebook_focus_enabled ||
+        settings.pane_autoresize_enabled ||
+        tweaks_focus_service_is_listening(g_focus_service));
+  }
+  if (changes & TWEAKS_CHANGE_COMPACT) {
+    // document state classes move to the new labels
+    docstates.clear_all();
+    compacttabs.update(settings.compact_tabs_enabled);
+    changes |= TWEAKS_CHANGE_DOC_STATE;
+    notebook_focus_schedule(nullptr);
+  }
+  if (changes & TWEAKS_CHANGE_DOC_STATE) {
+    docstates.update_all();
+  }
+  if (changes & TWEAKS_CHANGE_ACTIVITY) {
+    activity.update(settings.tab_activity_enabled);
+  }
+}
 
-  notebook_focus_update(settings.sidebar_focus_enabled ||
-                        settings.notebook_focus_enabled);
+// "refresh" emitted on the focus service
+void focus_service_refresh() {
+  settings_apply_changes(TWEAKS_CHANGE_FOCUS);
+}
 
-  g_handle_reload_config = 0;
+gboolean save_config(gpointer user_data) {
+  g_settings_unsaved = false;
+  settings.save();
   return false;
 }
 
-void on_pref_reload_config(GtkWidget *self, GtkWidget *dialog) {
-  if (g_handle_reload_config == 0) {
-    g_handle_reload_config = 1;
-    g_idle_add(reload_config, nullptr);
+// Applies only what the toggle affects; nothing is read or written.
+void on_pref_toggled(GtkToggleButton *self, gpointer user_data) {
+  auto const &toggle = pref_toggles[GPOINTER_TO_INT(user_data)];
+  gboolean before = settings.*toggle.member;
+
+  overlay.restore();
+  settings.*toggle.member = gtk_toggle_button_get_active(self);
+  overlay.apply();
+
+  if (settings.*toggle.member != before) {
+    settings_apply_changes(toggle.change);
+  }
+  g_settings_unsaved = true;
+}
+
+void on_pref_config_destroy(GtkWidget *self, gpointer user_data) {
+  if (g_settings_unsaved) {
+    g_settings_unsaved = false;
+    scheduler.add(TWEAKS_TASK_SAVE_SETTINGS, TWEAKS_PRIORITY_LOW,
+                  save_config);
   }
 }
 
+void on_pref_reload_config(GtkWidget *self, GtkWidget *dialog) {
+  scheduler.add(TWEAKS_TASK_RELOAD_CONFIG, TWEAKS_PRIORITY_DEFAULT,
+                reload_config);
+}
+
 void on_pref_save_config(GtkWidget *self, GtkWidget *dialog) {
-  settings.save();
+  scheduler.add(TWEAKS_TASK_SAVE_SETTINGS, TWEAKS_PRIORITY_LOW, save_config);
 }
 
 void on_pref_reset_config(GtkWidget *self, GtkWidget *dialog) {
@@ -274,261 +558,488 @@ void on_menu_preferences(GtkWidget *self, GtkWidget *dialog) {
   plugin_show_configure(geany_plugin);
 }
 
-/* ********************
- * Sidebar Tab Focus Callbacks
- */
+void on_stats_refresh(GtkWidget *self, GtkWidget *view) {
+  std::string report = counters.format();
+  gtk_text_buffer_set_text(gtk_text_view_get_buffer(GTK_TEXT_VIEW(view)),
+                           report.c_str(), -1);
+}
 
-void state_flags_changed(GtkNotebook *self, GtkStateFlags flags,
-                                gpointer user_data) {
-  DEBUG_STATUS_1(self);
+void on_stats_reset(GtkWidget *self, GtkWidget *view) {
+  counters.reset();
+  scheduler.reset_stats();
+  on_stats_refresh(self, view);
+}
 
-  if (g_handle_notebook_focus_highlight == 0) {
-    g_handle_notebook_focus_highlight = 1;
-    g_idle_add(notebook_focus_highlight_callback, self);
+void on_stats_export(GtkWidget *self, GtkWidget *dialog) {
+  GtkWidget *chooser = gtk_file_chooser_dialog_new(
+      "Export Statistics", GTK_WINDOW(dialog), GTK_FILE_CHOOSER_ACTION_SAVE,
+      "_Cancel", GTK_RESPONSE_CANCEL, "_Save", GTK_RESPONSE_ACCEPT, nullptr);
+  gtk_file_chooser_set_do_overwrite_confirmation(GTK_FILE_CHOOSER(chooser),
+                                                 true);
+  gtk_file_chooser_set_current_name(GTK_FILE_CHOOSER(chooser),
+                                    "xitweaks-stats.txt");
+
+  if (gtk_dialog_run(GTK_DIALOG(chooser)) == GTK_RESPONSE_ACCEPT) {
+    std::string fn = cstr_assign(
+        gtk_file_chooser_get_filename(GTK_FILE_CHOOSER(chooser)));
+    if (!counters.export_to(fn)) {
+      msgwin_status_add(_("Xi/Tweaks: could not write %s"), fn.c_str());
+    }
   }
+
+  gtk_widget_destroy(chooser);
 }
 
-void change_current_page(GtkNotebook *self, GtkStateFlags flags,
-                                gpointer user_data) {
-  DEBUG_STATUS_1(self);
+void on_menu_dump_trace(GtkWidget *self, GtkWidget *dialog) {
+  GDateTime *now = g_date_time_new_now_local();
+  std::string stamp = cstr_assign(g_date_time_format(now, "%Y%m%d-%H%M%S"));
+  g_date_time_unref(now);
+
+  std::string trace_fn = cstr_assign(g_build_filename(
+      geany_data->app->configdir, "plugins", "xitweaks",
+      ("xitweaks-" + stamp + ".trace").c_str(), nullptr));
 
-  if (g_handle_notebook_focus_highlight == 0) {
-    g_handle_notebook_focus_highlight = 1;
-    g_idle_add(notebook_focus_highlight_callback, self);
+  if (tracer.dump(trace_fn.c_str())) {
+    msgwin_status_add(_("Xi/Tweaks: event trace written to %s"),
+                      trace_fn.c_str());
+  } else {
+    msgwin_status_add(_("Xi/Tweaks: could not write %s"), trace_fn.c_str());
   }
 }
 
-void focus(GtkNotebook *self, GtkStateFlags flags, gpointer user_data) {
-  DEBUG_STATUS_1(self);
+/* ********************
+ * Sidebar Tab Focus Callbacks
+ */
 
-  if (g_handle_notebook_focus_highlight == 0) {
-    g_handle_notebook_focus_highlight = 1;
-    g_idle_add(notebook_focus_highlight_callback, self);
+// Signals connected on every tracked notebook.  Each of them goes through
+// notebook_signal_dispatch(), whatever its signature.
+static struct {
+  char const *name;
+  TweakSignalKind kind;
+} const notebook_signals[] = {
+    {"focus", TWEAKS_SIGNAL_FOCUS},
+    {"grab-focus", TWEAKS_SIGNAL_GRAB_FOCUS},
+    {"grab-notify", TWEAKS_SIGNAL_GRAB_NOTIFY},
+    {"set-focus-child", TWEAKS_SIGNAL_SET_FOCUS_CHILD},
+    {"switch-page", TWEAKS_SIGNAL_SWITCH_PAGE},
+
+    // keep the page vector in step
+    {"page-added", TWEAKS_SIGNAL_PAGE_ADDED},
+    {"page-removed", TWEAKS_SIGNAL_PAGE_REMOVED},
+    {"page-reordered", TWEAKS_SIGNAL_PAGE_REORDERED},
+};
+
+struct TweakSignalClosure {
+  GClosure closure;
+  TweakSignalKind kind;
+};
+
+void notebook_signal_dispatch(GClosure *closure, GValue *return_value,
+                              guint n_param_values,
+                              GValue const *param_values,
+                              gpointer invocation_hint,
+                              gpointer marshal_data) {
+  gint64 start = g_get_monotonic_time();
+  TweakSignalKind kind = reinterpret_cast<TweakSignalClosure *>(closure)->kind;
+  GtkNotebook *nb = GTK_NOTEBOOK(g_value_get_object(&param_values[0]));
+
+  DEBUG_STATUS_1(nb);
+
+  if (kind == TWEAKS_SIGNAL_PAGE_ADDED || kind == TWEAKS_SIGNAL_PAGE_REMOVED ||
+      kind == TWEAKS_SIGNAL_PAGE_REORDERED) {
+    TweakNotebook *entry = notebooks.find(nb);
+    GtkWidget *child = GTK_WIDGET(g_value_get_object(&param_values[1]));
+    guint page_num = g_value_get_uint(&param_values[2]);
+
+    if (kind == TWEAKS_SIGNAL_PAGE_ADDED) {
+      notebooks.page_added(entry, child, page_num);
+    } else if (kind == TWEAKS_SIGNAL_PAGE_REMOVED) {
+      notebooks.page_removed(entry, child, page_num);
+    } else {
+      notebooks.page_reordered(entry, child, page_num);
+    }
   }
-}
 
-void focus_tab(GtkNotebook *self, GtkStateFlags flags,
-                      gpointer user_data) {
-  DEBUG_STATUS_1(self);
+  notebook_focus_event(nb, kind);
 
-  if (g_handle_notebook_focus_highlight == 0) {
-    g_handle_notebook_focus_highlight = 1;
-    g_idle_add(notebook_focus_highlight_callback, self);
+  // "focus" expects a result; let GTK move focus as usual
+  if (return_value != nullptr && G_VALUE_HOLDS_BOOLEAN(return_value)) {
+    g_value_set_boolean(return_value, false);
   }
-}
 
-void move_focus_out(GtkNotebook *self, GtkStateFlags flags,
-                           gpointer user_data) {
-  DEBUG_STATUS_1(self);
+  counters.signal_us[kind] += g_get_monotonic_time() - start;
+}
 
-  if (g_handle_notebook_focus_highlight == 0) {
-    g_handle_notebook_focus_highlight = 1;
-    g_idle_add(notebook_focus_highlight_callback, self);
+guint notebook_focus_policy(TweakNotebook *entry) {
+  if (settings.notebook_focus_enabled ||
+      (settings.sidebar_focus_enabled &&
+       entry->kind == TWEAKS_NOTEBOOK_SIDEBAR)) {
+    return TWEAKS_POLICY_TAB | TWEAKS_POLICY_PAGE;
   }
+  return TWEAKS_POLICY_NONE;
 }
 
-void page_added(GtkNotebook *self, GtkStateFlags flags,
-                       gpointer user_data) {
-  DEBUG_STATUS_1(self);
+// Handlers are connected once per notebook and then only blocked and
+// unblocked, so toggling highlighting or reloading the config leaves the
+// notebooks' signal tables alone.
+void notebook_focus_connect(TweakNotebook *entry) {
+  entry->policy = notebook_focus_policy(entry);
 
-  if (g_handle_notebook_focus_highlight == 0) {
-    g_handle_notebook_focus_highlight = 1;
-    g_idle_add(notebook_focus_highlight_callback, self);
+  if (!entry->handlers.empty()) {
+    return;
   }
-}
 
-void page_removed(GtkNotebook *self, GtkStateFlags flags,
-                         gpointer user_data) {
-  DEBUG_STATUS_1(self);
+  // pages may have changed while nothing was listening
+  entry->pages_valid = false;
+
+  for (auto const &sig : notebook_signals) {
+    GClosure *closure =
+        g_closure_new_simple(sizeof(TweakSignalClosure), nullptr);
+    reinterpret_cast<TweakSignalClosure *>(closure)->kind = sig.kind;
+    g_closure_set_marshal(closure, notebook_signal_dispatch);
 
-  if (g_handle_notebook_focus_highlight == 0) {
-    g_handle_notebook_focus_highlight = 1;
-    g_idle_add(notebook_focus_highlight_callback, self);
+    entry->handlers.push_back(
+        g_signal_connect_closure(entry->notebook, sig.name, closure, false));
+    counters.handlers_connected++;
   }
 }
 
-void page_reordered(GtkNotebook *self, GtkStateFlags flags,
-                           gpointer user_data) {
-  DEBUG_STATUS_1(self);
+void notebook_focus_event(GtkNotebook *nb, TweakSignalKind kind) {
+  TWEAKS_PROBE_SCOPE1(signal, kind);
 
-  if (g_handle_notebook_focus_highlight == 0) {
-    g_handle_notebook_focus_highlight = 1;
-    g_idle_add(notebook_focus_highlight_callback, self);
-  }
+  counters.signals[kind]++;
+  tracer.record(TWEAKS_TRACE_SIGNAL, notebooks.kind_of(nb), kind);
+
+  notebook_focus_schedule(nb);
 }
 
-void reorder_tab(GtkNotebook *self, GtkStateFlags flags,
-                        gpointer user_data) {
-  DEBUG_STATUS_1(self);
+void notebook_focus_schedule(GtkNotebook *nb) {
+  // a pass would change nothing; enabling marks every notebook dirty
+  if (!g_notebook_focus_enabled) {
+    return;
+  }
+
+  notebooks.mark_dirty(notebooks.find(nb));
 
-  if (g_handle_notebook_focus_highlight == 0) {
-    g_handle_notebook_focus_highlight = 1;
-    g_idle_add(notebook_focus_highlight_callback, self);
+  counters.passes_requested++;
+  if (notebooks.is_bulk_loading()) {
+    counters.passes_deferred++;
+    return;
+  }
+  if (!g_window_active) {
+    counters.passes_inactive++;
+    return;
+  }
+  if (scheduler.is_pending(TWEAKS_TASK_HIGHLIGHT)) {
+    counters.passes_coalesced++;
   }
+  scheduler.add(TWEAKS_TASK_HIGHLIGHT, TWEAKS_PRIORITY_HIGH,
+                notebook_focus_highlight_callback);
 }
 
-void select_page(GtkNotebook *self, GtkStateFlags flags,
-                        gpointer user_data) {
-  DEBUG_STATUS_1(self);
+// Runs for every GtkWindow::set-focus, so notebooks that were created after
+// the plugin loaded (split views, detached windows) are picked up on focus.
+gboolean set_focus_hook(GSignalInvocationHint *hint, guint n_params,
+                        GValue const *params, gpointer user_data) {
+  TWEAKS_PROBE_SCOPE1(signal, TWEAKS_SIGNAL_WINDOW_SET_FOCUS);
 
-  if (g_handle_notebook_focus_highlight == 0) {
-    g_handle_notebook_focus_highlight = 1;
-    g_idle_add(notebook_focus_highlight_callback, self);
+  GtkWindow *window = GTK_WINDOW(g_value_get_object(&params[0]));
+  GtkWidget *widget = GTK_WIDGET(g_value_get_object(&params[1]));
+
+  if (window != geany_window && GTK_IS_DIALOG(window)) {
+    return true;
+  }
+
+  gint64 start = g_get_monotonic_time();
+  counters.signals[TWEAKS_SIGNAL_WINDOW_SET_FOCUS]++;
+  tracer.record(TWEAKS_TRACE_SIGNAL, TWEAKS_NOTEBOOK_OTHER,
+                TWEAKS_SIGNAL_WINDOW_SET_FOCUS);
+
+  for (GtkWidget *w = widget; w != nullptr; w = gtk_widget_get_parent(w)) {
+    if (GTK_IS_NOTEBOOK(w)) {
+      gboolean added = false;
+      TweakNotebook *entry =
+          notebooks.add(GTK_NOTEBOOK(w), TWEAKS_NOTEBOOK_OTHER, &added);
+      if (added) {
+        notebook_focus_connect(entry);
+      }
+      notebooks.mark_dirty(entry);
+    }
   }
+
+  notebook_focus_schedule(nullptr);
+
+  counters.signal_us[TWEAKS_SIGNAL_WINDOW_SET_FOCUS] +=
+      g_get_monotonic_time() - start;
+  return true;
 }
 
-void switch_page(GtkNotebook *self, GtkStateFlags flags,
-                        gpointer user_data) {
-  DEBUG_STATUS_1(self);
+void notebook_focus_update(gboolean enable) {
+  DEBUG_STATUS_0();
 
-  if (g_handle_notebook_focus_highlight == 0) {
-    g_handle_notebook_focus_highlight = 1;
-    g_idle_add(notebook_focus_highlight_callback, self);
+  for (TweakNotebook *entry : notebooks.get_notebooks()) {
+    entry->policy = notebook_focus_policy(entry);
   }
-}
 
-void set_focus_child(GtkNotebook *self, GtkStateFlags flags,
-                            gpointer user_data) {
-  DEBUG_STATUS_1(self);
+  if (enable && !g_notebook_focus_enabled) {
+    g_notebook_focus_enabled = true;
+
+    notebooks.set_blocked(false);
+    for (TweakNotebook *entry : notebooks.get_notebooks()) {
+      notebook_focus_connect(entry);
+    }
 
-  if (g_handle_notebook_focus_highlight == 0) {
-    g_handle_notebook_focus_highlight = 1;
-    g_idle_add(notebook_focus_highlight_callback, self);
+    g_set_focus_signal = g_signal_lookup("set-focus", GTK_TYPE_WINDOW);
+    g_handle_set_focus_hook = g_signal_add_emission_hook(
+        g_set_focus_signal, 0, set_focus_hook, nullptr, nullptr);
+  } else if (!enable && g_notebook_focus_enabled) {
+    g_notebook_focus_enabled = false;
+
+    g_signal_remove_emission_hook(g_set_focus_signal, g_handle_set_focus_hook);
+    g_handle_set_focus_hook = 0;
+
+    notebooks.set_blocked(true);
   }
-}
-void grab_focus(GtkNotebook *self, GtkStateFlags flags,
-                       gpointer user_data) {
-  DEBUG_STATUS_1(self);
 
-  if (g_handle_notebook_focus_highlight == 0) {
-    g_handle_notebook_focus_highlight = 1;
-    g_idle_add(notebook_focus_highlight_callback, self);
+  // Policies may have changed.  While another window, such as the
+  // preferences dialog, is active, nothing here has focus; the pass on
+  // activation catches up instead of unstyling everything now.
+  notebooks.mark_all_dirty();
+  if (!enable) {
+    notebook_focus_highlight(false);
+  } else if (!notebooks.is_bulk_loading() && g_window_active) {
+    notebook_focus_highlight(true);
+  } else if (!g_window_active) {
+    counters.passes_inactive++;
   }
 }
-void grab_notify(GtkNotebook *self, GtkStateFlags flags,
-                        gpointer user_data) {
-  DEBUG_STATUS_1(self);
 
-  if (g_handle_notebook_focus_highlight == 0) {
-    g_handle_notebook_focus_highlight = 1;
-    g_idle_add(notebook_focus_highlight_callback, self);
+// Opening a session adds every document in one go.  Rather than maintain page
+// vectors and request a pass per page, defer everything to a single pass.
+void notebook_bulk_load_begin() {
+  if (!notebooks.is_bulk_loading()) {
+    counters.bulk_loads++;
+    notebooks.begin_bulk_load();
   }
 }
 
-void notebook_focus_update(gboolean enable) {
-  DEBUG_STATUS_0();
+gboolean notebook_bulk_load_end(gpointer user_data) {
+  if (!notebooks.is_bulk_loading()) {
+    return false;
+  }
+  notebooks.end_bulk_load();
 
-  if (enable && !g_handle_focus_editor) {
-    g_handle_focus_sidebar =
-        g_signal_connect(geany_sidebar, "focus", G_CALLBACK(focus), nullptr);
-    g_handle_focus_msgwin =
-        g_signal_connect(geany_msgwin, "focus", G_CALLBACK(focus), nullptr);
-    g_handle_focus_editor =
-        g_signal_connect(geany_editor, "focus", G_CALLBACK(focus), nullptr);
-
-    g_handle_grab_focus_sidebar = g_signal_connect(
-        geany_sidebar, "grab-focus", G_CALLBACK(grab_focus), nullptr);
-    g_handle_grab_focus_msgwin = g_signal_connect(
-        geany_msgwin, "grab-focus", G_CALLBACK(grab_focus), nullptr);
-    g_handle_grab_focus_editor = g_signal_connect(
-        geany_editor, "grab-focus", G_CALLBACK(grab_focus), nullptr);
-
-    g_handle_grab_notify_sidebar = g_signal_connect(
-        geany_sidebar, "grab-notify", G_CALLBACK(grab_notify), nullptr);
-    g_handle_grab_notify_msgwin = g_signal_connect(
-        geany_msgwin, "grab-notify", G_CALLBACK(grab_notify), nullptr);
-    g_handle_grab_notify_editor = g_signal_connect(
-        geany_editor, "grab-notify", G_CALLBACK(grab_notify), nullptr);
-
-    g_handle_set_focus_child_sidebar = g_signal_connect(
-        geany_sidebar, "set-focus-child", G_CALLBACK(set_focus_child), nullptr);
-    g_handle_set_focus_child_msgwin = g_signal_connect(
-        geany_msgwin, "set-focus-child", G_CALLBACK(set_focus_child), nullptr);
-    g_handle_set_focus_child_editor = g_signal_connect(
-        geany_editor, "set-focus-child", G_CALLBACK(set_focus_child), nullptr);
-
-    g_handle_switch_page_sidebar = g_signal_connect(
-        geany_sidebar, "switch-page", G_CALLBACK(switch_page), nullptr);
-    g_handle_switch_page_msgwin = g_signal_connect(
-        geany_msgwin, "switch-page", G_CALLBACK(switch_page), nullptr);
-    g_handle_switch_page_editor = g_signal_connect(
-        geany_editor, "switch-page", G_CALLBACK(switch_page), nullptr);
+  docstates.update_all();
+  notebooks.mark_all_dirty();
 
-    notebook_focus_highlight(true);
+  // a pending reload finishes with a full pass of its own
+  if (!scheduler.is_pending(TWEAKS_TASK_RELOAD_CONFIG)) {
+    notebook_focus_schedule(nullptr);
   }
+  return false;
+}
 
-  if (!enable && g_handle_focus_editor) {
-    g_clear_signal_handler(&g_handle_focus_editor, GTK_WIDGET(geany_editor));
-    g_clear_signal_handler(&g_handle_focus_msgwin, GTK_WIDGET(geany_msgwin));
-    g_clear_signal_handler(&g_handle_focus_sidebar, GTK_WIDGET(geany_sidebar));
-    g_clear_signal_handler(&g_handle_grab_focus_editor,
-                           GTK_WIDGET(geany_editor));
-    g_clear_signal_handler(&g_handle_grab_focus_msgwin,
-                           GTK_WIDGET(geany_msgwin));
-    g_clear_signal_handler(&g_handle_grab_focus_sidebar,
-                           GTK_WIDGET(geany_sidebar));
-    g_clear_signal_handler(&g_handle_grab_notify_editor,
-                           GTK_WIDGET(geany_editor));
-    g_clear_signal_handler(&g_handle_grab_notify_msgwin,
-                           GTK_WIDGET(geany_msgwin));
-    g_clear_signal_handler(&g_handle_grab_notify_sidebar,
-                           GTK_WIDGET(geany_sidebar));
-    g_clear_signal_handler(&g_handle_set_focus_child_editor,
-                           GTK_WIDGET(geany_editor));
-    g_clear_signal_handler(&g_handle_set_focus_child_msgwin,
-                           GTK_WIDGET(geany_msgwin));
-    g_clear_signal_handler(&g_handle_set_focus_child_sidebar,
-                           GTK_WIDGET(geany_sidebar));
-    g_clear_signal_handler(&g_handle_switch_page_editor,
-                           GTK_WIDGET(geany_editor));
-    g_clear_signal_handler(&g_handle_switch_page_msgwin,
-                           GTK_WIDGET(geany_msgwin));
-    g_clear_signal_handler(&g_handle_switch_page_sidebar,
-                           GTK_WIDGET(geany_sidebar));
+// Switching to another application takes focus from every widget and gives
+// it back on return.  Keep the styles of the last focus target meanwhile
+// instead of unstyling and restyling every notebook.
+void window_active_notify(GObject *self, GParamSpec *pspec,
+                          gpointer user_data) {
+  g_window_active = gtk_window_is_active(geany_window);
+  window_active_update();
+
+  if (!g_window_active) {
+    // the modifier release will not arrive here
+    mru_commit();
+
+    // Focus-out reaches the focused widget before is-active changes.  The
+    // pass it scheduled would unstyle everything; keep the notebooks dirty
+    // for the catch-up pass instead.
+    if (scheduler.is_pending(TWEAKS_TASK_HIGHLIGHT)) {
+      scheduler.cancel(TWEAKS_TASK_HIGHLIGHT);
+      counters.passes_inactive++;
+    }
+  }
 
-    notebook_focus_highlight(false);
+  // catch up on anything that changed while inactive
+  if (g_window_active && !notebooks.get_dirty().empty()) {
+    notebook_focus_schedule(nullptr);
+  }
+}
+
+void window_active_update() {
+  GtkStyleContext *context =
+      gtk_widget_get_style_context(GTK_WIDGET(geany_window));
+
+  if (!g_window_active && settings.inactive_window_dimmed) {
+    gtk_style_context_add_class(context, "xitweaks-inactive");
+  } else {
+    gtk_style_context_remove_class(context, "xitweaks-inactive");
   }
 }
 
 gboolean notebook_focus_highlight_callback(gpointer user_data) {
   notebook_focus_highlight(true);
-  g_handle_notebook_focus_highlight = 0;
   return false;
 }
 
 gboolean notebook_focus_highlight(gboolean highlight) {
-  static GtkNotebook *notebooks[3] = {geany_sidebar, geany_editor,
-                                      geany_msgwin};
+  TWEAKS_PROBE_SCOPE(notebook_focus_highlight);
 
   if (!settings.sidebar_focus_enabled && !settings.notebook_focus_enabled) {
     highlight = false;
   }
 
-  for (GtkNotebook *nb : notebooks) {
-    gint num_pages = gtk_notebook_get_n_pages(nb);
+  // focus may have left a notebook without it emitting anything
+  notebooks.mark_dirty(notebooks.focused);
+  notebooks.focused = nullptr;
+
+  // other plugins and pane resizing need focus even without highlighting
+  gboolean need_focus = tweaks_focus_service_is_listening(g_focus_service) ||
+                        settings.pane_autoresize_enabled;
+  GtkWidget *focused_page = nullptr;
+  TweakQualityLevel level = quality.get_level();
+
+  gint64 start = g_get_monotonic_time();
+  guint pages_visited = 0;
+  guint style_writes = 0;
+  tracer.record(TWEAKS_TRACE_PASS_BEGIN, TWEAKS_NOTEBOOK_OTHER, 0,
+                notebooks.get_dirty().size());
+
+  for (TweakNotebook *entry : notebooks.get_dirty()) {
+    GtkNotebook *nb = entry->notebook;
     gint cur_page = gtk_notebook_get_current_page(nb);
 
-    for (int i = 0; i < num_pages; i++) {
-      GtkWidget *page = gtk_notebook_get_nth_page(nb, i);
-      GtkWidget *label = gtk_notebook_get_tab_label(nb, page);
-
-      if (highlight && i == cur_page &&
-          (gtk_widget_has_focus(GTK_WIDGET(nb)) ||
-           gtk_widget_has_focus(find_focus_widget(GTK_WIDGET(nb))) ||
-           gtk_widget_has_focus(page) ||
-           gtk_widget_has_focus(find_focus_widget(GTK_WIDGET(page))) ||
-           gtk_widget_has_focus(label)) &&
-          (settings.notebook_focus_enabled ||
-           (settings.sidebar_focus_enabled && nb == geany_sidebar))) {
-        gtk_widget_set_name(label, "geany-xitweaks-notebook-tab-focus");
-        gtk_widget_set_name(page, "geany-xitweaks-notebook-page-focus");
-      } else {
-        gtk_widget_set_name(label, "geany-xitweaks-notebook-tab-unfocus");
-        gtk_widget_set_name(page, "geany-xitweaks-notebook-page-unfocus");
+    gboolean rebuilt = false;
+    if (!entry->pages_valid ||
+        entry->pages.size() != guint(gtk_notebook_get_n_pages(nb))) {
+      notebooks.rebuild_pages(entry);
+      rebuilt = true;
+    }
+    tracer.record(TWEAKS_TRACE_NOTEBOOK, entry->kind,
+                  cur_page < 0 ? TWEAKS_TRACE_NO_PAGE
+                               : MIN(cur_page, TWEAKS_TRACE_NO_PAGE - 1),
+                  entry->pages.size());
+
+    entry->focused = false;
+
+    // focus is needed even where nothing gets styled
+    if (cur_page >= 0 &&
+        (need_focus || (highlight && entry->policy != TWEAKS_POLICY_NONE))) {
+      GtkWidget *page = entry->pages[cur_page].page;
+      GtkWidget *label = entry->pages[cur_page].label;
+
+      if (gtk_widget_has_focus(GTK_WIDGET(nb)) ||
+          gtk_widget_has_focus(find_focus_widget(GTK_WIDGET(nb))) ||
+          gtk_widget_has_focus(page) ||
+          gtk_widget_has_focus(find_focus_widget(GTK_WIDGET(page))) ||
+          gtk_widget_has_focus(label)) {
+        entry->focused = true;
+        notebooks.focused = entry;
+        focused_page = page;
+      }
+    }
+
+    guint policy = entry->policy;
+    if (level >= TWEAKS_QUALITY_LABEL_ONLY) {
+      policy &= ~TWEAKS_POLICY_PAGE;
+    }
+
+    int focus_page = entry->focus_page;
+    entry->focus_page = -1;
+
+    auto style_page = [&](int i) {
+      TweakPage &page = entry->pages[i];
+      gboolean is_focus = highlight && entry->focused && i == cur_page;
+
+      // a reduced pass names only what it has to
+      gboolean skip_tab =
+          page.tab_state == TWEAKS_STYLE_UNKNOWN && i != cur_page &&
+          (level >= TWEAKS_QUALITY_ACTIVE_TAB ||
+           (level >= TWEAKS_QUALITY_VISIBLE_TABS &&
+            !gtk_widget_get_mapped(page.label)));
+      gboolean skip_page = page.page_state == TWEAKS_STYLE_UNKNOWN &&
+                           level >= TWEAKS_QUALITY_LABEL_ONLY;
+
+      // Only transitions are written.  Each still allocates, as GTK copies
+      // the name; passes where focus stays put allocate nothing.
+      guint8 tab_state = is_focus && (policy & TWEAKS_POLICY_TAB)
+                             ? TWEAKS_STYLE_FOCUS
+                             : TWEAKS_STYLE_UNFOCUS;
+      if (page.tab_state != tab_state && !skip_tab) {
+        gtk_widget_set_name(page.label,
+                            tab_state == TWEAKS_STYLE_FOCUS
+                                ? "geany-xitweaks-notebook-tab-focus"
+                                : "geany-xitweaks-notebook-tab-unfocus");
+        page.tab_state = tab_state;
+        style_writes++;
+      }
+
+      guint8 page_state = is_focus && (policy & TWEAKS_POLICY_PAGE)
+                              ? TWEAKS_STYLE_FOCUS
+                              : TWEAKS_STYLE_UNFOCUS;
+      if (page.page_state != page_state && !skip_page) {
+        gtk_widget_set_name(page.page,
+                            page_state == TWEAKS_STYLE_FOCUS
+                                ? "geany-xitweaks-notebook-page-focus"
+                                : "geany-xitweaks-notebook-page-unfocus");
+        page.page_state = page_state;
+        style_writes++;
+      }
+
+      if (page.tab_state == TWEAKS_STYLE_FOCUS ||
+          page.page_state == TWEAKS_STYLE_FOCUS) {
+        entry->focus_page = i;
+      }
+      pages_visited++;
+    };
+
+    // Every other page is already unnamed or left unnamed, so the lower
+    // levels visit only the current page and the one named as focused.
+    // Tabs shown in the strip are still named after the pages are rebuilt.
+    if (level < TWEAKS_QUALITY_VISIBLE_TABS ||
+        (level == TWEAKS_QUALITY_VISIBLE_TABS && rebuilt)) {
+      for (int i = 0; i < int(entry->pages.size()); i++) {
+        style_page(i);
+      }
+    } else {
+      if (cur_page >= 0) {
+        style_page(cur_page);
+      }
+      if (focus_page >= 0 && focus_page != cur_page &&
+          focus_page < int(entry->pages.size())) {
+        style_page(focus_page);
       }
     }
   }
 
+  notebooks.clear_dirty();
+
+  tweaks_focus_service_update(
+      g_focus_service,
+      notebooks.focused ? gint(notebooks.focused->kind)
+                        : gint(XITWEAKS_FOCUS_NONE),
+      focused_page,
+      notebooks.focused ? gtk_window_get_focus(geany_window) : nullptr);
+  paneresize.update(notebooks.focused ? notebooks.focused->kind
+                                      : TWEAKS_NOTEBOOK_OTHER);
+
+  tracer.record(TWEAKS_TRACE_PASS_END,
+                notebooks.focused ? notebooks.focused->kind
+                                  : TWEAKS_TRACE_NO_FOCUS,
+                MIN(pages_visited, G_MAXUINT16), style_writes);
+
+  counters.pages_visited += pages_visited;
+  counters.set_name_calls += style_writes;
+  gint64 duration = g_get_monotonic_time() - start;
+  counters.add_pass_duration(duration);
+
+  // pages skipped at the lower level are named by the next pass
+  if (highlight && quality.add_pass_duration(duration)) {
+    notebooks.mark_all_dirty();
+  }
+
+  latency.pass_done(GTK_WIDGET(geany_window), style_writes);
+
   return false;
 }
 
@@ -537,6 +1048,8 @@ gboolean notebook_focus_highlight(gboolean highlight) {
  */
 
 void on_switch_focus_editor_sidebar_msgwin() {
+  latency.key_pressed();
+
   GeanyDocument *doc = document_get_current();
   if (doc != nullptr) {
     gint cur_page = gtk_notebook_get_current_page(geany_sidebar);
@@ -559,11 +1072,59 @@ void on_switch_focus_editor_sidebar_msgwin() {
   }
 }
 
+// Documents are previewed while the modifiers of the keybinding are held;
+// releasing one makes the shown document the most recent.
+void on_mru_step(gboolean older) {
+  GeanyDocument *doc = mru.step(older);
+  if (doc == nullptr) {
+    return;
+  }
+
+  // GTK has to look up the page index itself
+  gtk_notebook_set_current_page(geany_editor, document_get_notebook_page(doc));
+  ui_set_statusbar(false, _("Recent document: %s"), DOC_FILENAME(doc));
+
+  GdkModifierType state = GdkModifierType(0);
+  gtk_get_current_event_state(&state);
+  if ((state & gtk_accelerator_get_default_mod_mask()) == 0) {
+    mru_commit();
+  } else if (g_handle_mru_key_release == 0) {
+    g_handle_mru_key_release =
+        g_signal_connect(geany_window, "key-release-event",
+                         G_CALLBACK(on_mru_key_release), nullptr);
+  }
+}
+
+gboolean on_mru_key_release(GtkWidget *self, GdkEventKey *event,
+                            gpointer user_data) {
+  if (event->is_modifier) {
+    mru_commit();
+  }
+  return false;
+}
+
+void mru_commit() {
+  if (g_handle_mru_key_release != 0) {
+    g_signal_handler_disconnect(geany_window, g_handle_mru_key_release);
+    g_handle_mru_key_release = 0;
+  }
+  mru.commit();
+}
+
 bool on_key_binding(int key_id) {
   switch (key_id) {
     case TWEAKS_KEY_SWITCH_FOCUS_EDITOR_SIDEBAR_MSGWIN:
       on_switch_focus_editor_sidebar_msgwin();
       break;
+    case TWEAKS_KEY_MRU_OLDER:
+      on_mru_step(true);
+      break;
+    case TWEAKS_KEY_MRU_NEWER:
+      on_mru_step(false);
+      break;
+    case TWEAKS_KEY_QUICK_SWITCHER:
+      switcher.show(geany_window, geany_sidebar, geany_msgwin);
+      break;
     default:
       return false;
   }
@@ -573,16 +1134,18 @@ bool on_key_binding(int key_id) {
 GtkWidget *find_focus_widget(GtkWidget *widget) {
   GtkWidget *focus = nullptr;
 
+  counters.find_focus_calls++;
+  if (++counters.find_focus_depth > counters.find_focus_max_depth) {
+    counters.find_focus_max_depth = counters.find_focus_depth;
+  }
+
   // optimized simple case
   if (GTK_IS_BIN(widget)) {
     focus = find_focus_widget(gtk_bin_get_child(GTK_BIN(widget)));
   } else if (GTK_IS_CONTAINER(widget)) {
-    GList *children = gtk_container_get_children(GTK_CONTAINER(widget));
-    GList *node;
-
-    for (node = children; node && !focus; node = node->next)
-      focus = find_focus_widget(GTK_WIDGET(node->data));
-    g_list_free(children);
+    // visit children in place rather than copying them into a GList
+    gtk_container_foreach(GTK_CONTAINER(widget), find_focus_widget_child,
+                          &focus);
   }
 
   /* Some containers handled above might not have children and be what we want
@@ -591,42 +1154,102 @@ GtkWidget *find_focus_widget(GtkWidget *widget) {
   if (!focus && gtk_widget_get_can_focus(widget)) {
     focus = widget;
   }
+
+  counters.find_focus_depth--;
   return focus;
 }
 
+void find_focus_widget_child(GtkWidget *child, gpointer user_data) {
+  GtkWidget **focus = static_cast<GtkWidget **>(user_data);
+  if (*focus == nullptr) {
+    *focus = find_focus_widget(child);
+  }
+}
+
 /* ********************
  * Geany Signal Callbacks
  */
 
 void on_document_signal(GObject *obj, GeanyDocument *doc,
-                               gpointer user_data) {}
+                               gpointer user_data) {
+  docstates.update(doc);
+  mru.add(doc);
+  switcher.add_document(doc);
+}
+
+void on_document_activate_signal(GObject *obj, GeanyDocument *doc,
+                                 gpointer user_data) {
+  docstates.update(doc);
+  mru.touch(doc);
+}
+
+void on_document_close_signal(GObject *obj, GeanyDocument *doc,
+                              gpointer user_data) {
+  mru.remove(doc);
+  switcher.remove_document(doc);
+}
+
+void on_document_filetype_signal(GObject *obj, GeanyDocument *doc,
+                                 GeanyFiletype *filetype_old,
+                                 gpointer user_data) {
+  docstates.update(doc);
+}
 
 void on_startup_signal(GObject *obj, GeanyDocument *doc,
                               gpointer user_data) {
-  if (g_handle_reload_config == 0) {
-    g_handle_reload_config = 1;
-    g_idle_add(reload_config, nullptr);
-  }
+  TWEAKS_PROBE_SCOPE(startup_signal);
+
+  // queued first, so its full pass is the only one when loading ends
+  scheduler.add(TWEAKS_TASK_RELOAD_CONFIG, TWEAKS_PRIORITY_DEFAULT,
+                reload_config);
+
+  scheduler.cancel(TWEAKS_TASK_BULK_LOAD_END);
+  notebook_bulk_load_end(nullptr);
 }
 
 void on_project_signal(GObject *obj, GKeyFile *config,
                               gpointer user_data) {}
 
+void on_project_open_signal(GObject *obj, GKeyFile *config,
+                            gpointer user_data) {
+  // settings from the project keyfile; set_project() updates documents
+  guint changes = overlay.open(config);
+  settings_apply_changes(changes & ~TWEAKS_CHANGE_DOC_STATE);
+  docstates.set_project(geany_data->app->project);
+
+  // session files are opened after this signal; end once they have settled
+  notebook_bulk_load_begin();
+  scheduler.add(TWEAKS_TASK_BULK_LOAD_END, TWEAKS_PRIORITY_LOW,
+                notebook_bulk_load_end);
+}
+
+void on_project_close_signal(GObject *obj, gpointer user_data) {
+  guint changes = overlay.close();
+  settings_apply_changes(changes & ~TWEAKS_CHANGE_DOC_STATE);
+  docstates.set_project(nullptr);
+}
+
 bool on_editor_notify(GObject *obj, GeanyEditor *editor,
                              SCNotification *notif, gpointer user_data) {
+  TWEAKS_PROBE_SCOPE1(editor_notify, notif->nmhdr.code);
+
+  counters.editor_notify++;
+  tracer.record(TWEAKS_TRACE_EDITOR_NOTIFY, TWEAKS_NOTEBOOK_EDITOR,
+                notif->nmhdr.code);
+
   switch (notif->nmhdr.code) {
-    case SCN_FOCUSIN:
-    case SCEN_SETFOCUS:
-    case SCN_UPDATEUI:
-    case SCEN_CHANGE:
-    case SCN_FOCUSOUT:
-    case SCEN_KILLFOCUS:
+    case SCN_SAVEPOINTREACHED:
+    case SCN_SAVEPOINTLEFT:
+      docstates.set_modified(editor->document,
+                             notif->nmhdr.code == SCN_SAVEPOINTLEFT);
+      break;
     default:
-      if (g_handle_notebook_focus_highlight == 0) {
-        g_handle_notebook_focus_highlight = 1;
-        g_idle_add(notebook_focus_highlight_callback, nullptr);
-      }
       break;
   }
+
+  if (trace_event_schedules_pass(TWEAKS_TRACE_EDITOR_NOTIFY,
+                                 notif->nmhdr.code)) {
+    notebook_focus_schedule(geany_editor);
+  }
   return false;
 }
@@ -19,15 +19,32 @@
 #include <locale>
 
 #include "geanyplugin.h"
+#include "trace.h"
 
 extern GeanyKeyGroup *keybindings_get_core_group(guint id);
 
 extern GeanyPlugin *geany_plugin;
 extern GeanyData *geany_data;
 extern class TweakSettings settings;
+extern class TweakScheduler scheduler;
+extern class TweakNotebookRegistry notebooks;
+extern class TweakCounters counters;
+extern class TweakDocStates docstates;
+extern class TweakTabRules tabrules;
+extern class TweakMru mru;
+extern class TweakSwitcher switcher;
+extern class TweakProjectOverlay overlay;
+extern class TweakActivity activity;
+extern class TweakLatencyProbe latency;
+extern class TweakQuality quality;
+extern class TweakPaneResize paneresize;
+extern class TweakCompactTabs compacttabs;
 
 enum TweakShortcuts {
   TWEAKS_KEY_SWITCH_FOCUS_EDITOR_SIDEBAR_MSGWIN,
+  TWEAKS_KEY_MRU_OLDER,
+  TWEAKS_KEY_MRU_NEWER,
+  TWEAKS_KEY_QUICK_SWITCHER,
 
   TWEAKS_KEY_COUNT,
 };
@@ -37,15 +54,37 @@ gboolean tweaks_init(GeanyPlugin *plugin, gpointer data);
 void tweaks_cleanup(GeanyPlugin *plugin, gpointer data);
 GtkWidget *tweaks_configure(GeanyPlugin *plugin, GtkDialog *dialog,
                                    gpointer pdata);
+GtkWidget *tweaks_configure_config(GtkDialog *dialog);
+GtkWidget *tweaks_configure_stats(GtkDialog *dialog);
 
 // Sidebar Tab Focus Callbacks
+void notebook_signal_dispatch(GClosure *closure, GValue *return_value,
+                              guint n_param_values,
+                              GValue const *param_values,
+                              gpointer invocation_hint, gpointer marshal_data);
+guint notebook_focus_policy(struct TweakNotebook *entry);
+void notebook_focus_connect(struct TweakNotebook *entry);
+void notebook_focus_event(GtkNotebook *nb, TweakSignalKind kind);
+void notebook_focus_schedule(GtkNotebook *nb);
+gboolean set_focus_hook(GSignalInvocationHint *hint, guint n_params,
+                        GValue const *params, gpointer user_data);
 void notebook_focus_update(gboolean enable);
+void notebook_bulk_load_begin();
+gboolean notebook_bulk_load_end(gpointer user_data);
+void window_active_notify(GObject *self, GParamSpec *pspec,
+                          gpointer user_data);
+void window_active_update();
 
 gboolean notebook_focus_highlight_callback(gpointer user_data);
 gboolean notebook_focus_highlight(gboolean highlight);
 
 // Preferences Callbacks
 gboolean reload_config(gpointer user_data);
+void settings_apply_changes(guint changes);
+void focus_service_refresh();
+gboolean save_config(gpointer user_data);
+void on_pref_toggled(GtkToggleButton *self, gpointer user_data);
+void on_pref_config_destroy(GtkWidget *self, gpointer user_data);
 void on_pref_reload_config(GtkWidget *self = nullptr,
                                   GtkWidget *dialog = nullptr);
 void on_pref_save_config(GtkWidget *self, GtkWidget *dialog);
@@ -53,11 +92,22 @@ void on_pref_reset_config(GtkWidget *self, GtkWidget *dialog);
 void on_pref_open_config_folder(GtkWidget *self, GtkWidget *dialog);
 void on_pref_edit_config(GtkWidget *self, GtkWidget *dialog);
 void on_menu_preferences(GtkWidget *self, GtkWidget *dialog);
+void on_menu_dump_trace(GtkWidget *self, GtkWidget *dialog);
+
+// Statistics Callbacks
+void on_stats_refresh(GtkWidget *self, GtkWidget *view);
+void on_stats_reset(GtkWidget *self, GtkWidget *view);
+void on_stats_export(GtkWidget *self, GtkWidget *dialog);
 
 // Keybinding Functions and Callbacks
 void on_switch_focus_editor_sidebar_msgwin();
+void on_mru_step(gboolean older);
+gboolean on_mru_key_release(GtkWidget *self, GdkEventKey *event,
+                            gpointer user_data);
+void mru_commit();
 bool on_key_binding(int key_id);
 GtkWidget *find_focus_widget(GtkWidget *widget);
+void find_focus_widget_child(GtkWidget *child, gpointer user_data);
 
 // Geany Signal Callbacks
 void on_startup_signal(GObject *obj, GeanyDocument *doc,
@@ -66,6 +116,16 @@ void on_document_signal(GObject *obj, GeanyDocument *doc,
                                gpointer user_data);
 void on_project_signal(GObject *obj, GKeyFile *config,
                               gpointer user_data);
+void on_project_open_signal(GObject *obj, GKeyFile *config,
+                            gpointer user_data);
+void on_project_close_signal(GObject *obj, gpointer user_data);
+void on_document_activate_signal(GObject *obj, GeanyDocument *doc,
+                                 gpointer user_data);
+void on_document_close_signal(GObject *obj, GeanyDocument *doc,
+                              gpointer user_data);
+void on_document_filetype_signal(GObject *obj, GeanyDocument *doc,
+                                 GeanyFiletype *filetype_old,
+                                 gpointer user_data);
 bool on_editor_notify(GObject *obj, GeanyEditor *editor,
                              SCNotification *notif, gpointer user_data);
 
@@ -3,6 +3,9 @@
 #include "prefs.h"
 
 #include "auxiliary.h"
+#include "overlay.h"
+#include "probes.h"
+#include "tabrules.h"
 
 // Global Variables
 TweakSettings settings;
@@ -10,6 +13,8 @@ TweakSettings settings;
 // Functions
 
 void TweakSettings::open() {
+  TWEAKS_PROBE_SCOPE(settings_open);
+
   std::string conf_fn =
       cstr_assign(g_build_filename(geany_data->app->configdir, "plugins",
                                    "xitweaks", "xitweaks.conf", nullptr));
@@ -29,6 +34,7 @@ void TweakSettings::open() {
       nullptr);
 
   settings.load(kf);
+  overlay.reapply();
 
   GKEY_FILE_FREE(kf);
 }
@@ -56,6 +62,8 @@ void TweakSettings::save_default() {
 }
 
 void TweakSettings::save() {
+  TWEAKS_PROBE_SCOPE(settings_save);
+
   GKeyFile *kf = g_key_file_new();
   std::string fn =
       cstr_assign(g_build_filename(geany_data->app->configdir, "plugins",
@@ -67,9 +75,20 @@ void TweakSettings::save() {
       GKeyFileFlags(G_KEY_FILE_KEEP_COMMENTS | G_KEY_FILE_KEEP_TRANSLATIONS),
       nullptr);
 
-  // Update settings with new contents
+  // Update settings with new contents, not project overrides
+  overlay.restore();
   SET_KEY(boolean, "sidebar_focus_enabled", sidebar_focus_enabled);
   SET_KEY(boolean, "notebook_focus_enabled", notebook_focus_enabled);
+  SET_KEY(boolean, "inactive_window_dimmed", inactive_window_dimmed);
+  SET_KEY(boolean, "doc_state_enabled", doc_state_enabled);
+  SET_KEY(boolean, "tab_activity_enabled", tab_activity_enabled);
+  SET_KEY(boolean, "adaptive_quality_enabled", adaptive_quality_enabled);
+  SET_KEY(integer, "highlight_budget_us", highlight_budget_us);
+  SET_KEY(boolean, "pane_autoresize_enabled", pane_autoresize_enabled);
+  SET_KEY(integer, "sidebar_focus_width", sidebar_focus_width);
+  SET_KEY(integer, "msgwin_focus_height", msgwin_focus_height);
+  SET_KEY(boolean, "compact_tabs_enabled", compact_tabs_enabled);
+  overlay.apply();
 
   // Store back on disk
   std::string contents = cstr_assign(g_key_file_to_data(kf, nullptr, nullptr));
@@ -81,10 +100,21 @@ void TweakSettings::save() {
 }
 
 void TweakSettings::load(GKeyFile *kf) {
+  tabrules.load(kf);
+
   if (!g_key_file_has_group(kf, "tweaks")) {
     return;
   }
 
   GET_KEY_BOOLEAN(sidebar_focus_enabled, false);
   GET_KEY_BOOLEAN(notebook_focus_enabled, false);
+  GET_KEY_BOOLEAN(inactive_window_dimmed, false);
+  GET_KEY_BOOLEAN(doc_state_enabled, false);
+  GET_KEY_BOOLEAN(tab_activity_enabled, false);
+  GET_KEY_BOOLEAN(adaptive_quality_enabled, true);
+  GET_KEY_INTEGER(highlight_budget_us, 2000, 100);
+  GET_KEY_BOOLEAN(pane_autoresize_enabled, false);
+  GET_KEY_INTEGER(sidebar_focus_width, 360, 50);
+  GET_KEY_INTEGER(msgwin_focus_height, 280, 50);
+  GET_KEY_BOOLEAN(compact_tabs_enabled, false);
 }
@@ -8,7 +8,6 @@
 class TweakSettings {
  public:
   TweakSettings() = default;
-  ~TweakSettings() { save(); }
 
   void open();
   void load(GKeyFile *kf);
@@ -18,6 +17,15 @@ class TweakSettings {
  public:
   gboolean sidebar_focus_enabled = false;
   gboolean notebook_focus_enabled = false;
+  gboolean inactive_window_dimmed = false;
+  gboolean doc_state_enabled = false;
+  gboolean tab_activity_enabled = false;
+  gboolean adaptive_quality_enabled = true;
+  gint highlight_budget_us = 2000;
+  gboolean pane_autoresize_enabled = false;
+  gint sidebar_focus_width = 360;
+  gint msgwin_focus_height = 280;
+  gboolean compact_tabs_enabled = false;
 };
 
 // Macros to make loading settings easier
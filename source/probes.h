@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// Optional tracepoints for system profilers.  Without -Dusdt or -Dsysprof
+// every macro expands to nothing.
+//
+//   TWEAKS_PROBE_SCOPE(name)        fires xitweaks:name__entry now and
+//                                   xitweaks:name__return at scope exit
+//   TWEAKS_PROBE_SCOPE1(name, arg)  same, passing an integer argument
+//
+// With sysprof, the scope is also recorded as a mark in group "xitweaks".
+
+#pragma once
+
+#include <stdint.h>
+
+#include "config.h"
+
+#ifdef HAVE_USDT
+#include <sys/sdt.h>
+#define TWEAKS_PROBE(name) DTRACE_PROBE(xitweaks, name)
+#define TWEAKS_PROBE1(name, arg) DTRACE_PROBE1(xitweaks, name, arg)
+#else
+#define TWEAKS_PROBE(name)
+#define TWEAKS_PROBE1(name, arg)
+#endif  // HAVE_USDT
+
+#ifdef HAVE_SYSPROF
+#include <sysprof-capture.h>
+#endif  // HAVE_SYSPROF
+
+#if defined(HAVE_USDT) || defined(HAVE_SYSPROF)
+
+template <typename OnExit>
+class TweakProbeScope {
+ public:
+  TweakProbeScope(char const *name, OnExit on_exit)
+      : name(name), on_exit(on_exit) {
+#ifdef HAVE_SYSPROF
+    start = SYSPROF_CAPTURE_CURRENT_TIME;
+#endif
+  }
+
+  ~TweakProbeScope() {
+    on_exit();
+#ifdef HAVE_SYSPROF
+    sysprof_collector_mark(start, SYSPROF_CAPTURE_CURRENT_TIME - start,
+                           "xitweaks", name, nullptr);
+#endif
+  }
+
+ private:
+  char const *name;
+  OnExit on_exit;
+#ifdef HAVE_SYSPROF
+  int64_t start = 0;
+#endif
+};
+
+#define TWEAKS_PROBE_SCOPE(name) \
+  TWEAKS_PROBE(name##__entry);   \
+  TweakProbeScope _tweaks_probe_scope(#name, [] { TWEAKS_PROBE(name##__return); })
+
+#define TWEAKS_PROBE_SCOPE1(name, arg)                            \
+  long _tweaks_probe_arg = (long)(arg);                           \
+  TWEAKS_PROBE1(name##__entry, _tweaks_probe_arg);                \
+  TweakProbeScope _tweaks_probe_scope(#name, [_tweaks_probe_arg] { \
+    TWEAKS_PROBE1(name##__return, _tweaks_probe_arg);             \
+  })
+
+#else
+
+#define TWEAKS_PROBE_SCOPE(name) \
+  do {                           \
+  } while (0)
+#define TWEAKS_PROBE_SCOPE1(name, arg) \
+  do {                                 \
+  } while (0)
+
+#endif  // HAVE_USDT || HAVE_SYSPROF
@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "quality.h"
+
+// A catch-up pass after stepping up visits every page, so a single slow
+// pass is not enough to step down again.
+#define TWEAKS_QUALITY_STEP_DOWN_PASSES 3
+#define TWEAKS_QUALITY_STEP_UP_PASSES 20
+
+// Global Variables
+TweakQuality quality;
+
+// Functions
+
+void TweakQuality::configure(gboolean enable, gint64 budget) {
+  enabled = enable;
+  budget_us = budget;
+  over = 0;
+  under = 0;
+
+  if (!enabled && level != TWEAKS_QUALITY_FULL) {
+    set_level(TWEAKS_QUALITY_FULL, 0);
+  }
+}
+
+// Returns true when the level went up, so skipped pages need a full pass.
+gboolean TweakQuality::add_pass_duration(gint64 duration_us) {
+  if (!enabled) {
+    return false;
+  }
+
+  if (duration_us > budget_us) {
+    under = 0;
+    if (++over >= TWEAKS_QUALITY_STEP_DOWN_PASSES &&
+        level < TWEAKS_QUALITY_ACTIVE_TAB) {
+      set_level(TweakQualityLevel(level + 1), duration_us);
+    }
+    return false;
+  }
+
+  over = 0;
+  if (duration_us * 2 > budget_us) {
+    under = 0;
+    return false;
+  }
+
+  if (++under >= TWEAKS_QUALITY_STEP_UP_PASSES &&
+      level > TWEAKS_QUALITY_FULL) {
+    set_level(TweakQualityLevel(level - 1), duration_us);
+    return true;
+  }
+  return false;
+}
+
+void TweakQuality::set_level(TweakQualityLevel new_level,
+                             gint64 duration_us) {
+  if (new_level > level) {
+    steps_down++;
+  } else {
+    steps_up++;
+  }
+  level = new_level;
+  over = 0;
+  under = 0;
+
+  msgwin_status_add(_("Xi/Tweaks: focus highlighting %s (pass %.1f ms, "
+                      "budget %.1f ms)"),
+                    level_name(level), duration_us / 1000.0,
+                    budget_us / 1000.0);
+}
+
+char const *TweakQuality::level_name(TweakQualityLevel level) {
+  switch (level) {
+    case TWEAKS_QUALITY_FULL:
+      return "full";
+    case TWEAKS_QUALITY_LABEL_ONLY:
+      return "label only";
+    case TWEAKS_QUALITY_VISIBLE_TABS:
+      return "visible tabs only";
+    case TWEAKS_QUALITY_ACTIVE_TAB:
+      return "active tab only";
+    default:
+      return "unknown";
+  }
+}
@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "plugin.h"
+
+// Each level keeps the work of the ones below it and skips more style
+// writes.  Writes that would restore an old focus style are never skipped,
+// so a skipped tab or page is at worst left without either name.  From
+// VISIBLE_TABS on, a pass visits only the current page of each notebook
+// and the page named as focused, not every page.
+enum TweakQualityLevel {
+  TWEAKS_QUALITY_FULL,          // tab labels and pages
+  TWEAKS_QUALITY_LABEL_ONLY,    // tab labels only
+  TWEAKS_QUALITY_VISIBLE_TABS,  // tab labels shown, after a rebuild
+  TWEAKS_QUALITY_ACTIVE_TAB,    // the current tab label of each notebook
+
+  TWEAKS_QUALITY_COUNT,
+};
+
+// Steps the highlight pass down a level after a run of passes over the
+// time budget, and back up after a longer run well under it.
+class TweakQuality {
+ public:
+  TweakQuality() = default;
+
+  void configure(gboolean enable, gint64 budget);
+  gboolean add_pass_duration(gint64 duration_us);
+
+  TweakQualityLevel get_level() const { return level; }
+  gint64 get_budget_us() const { return budget_us; }
+  guint64 get_steps_down() const { return steps_down; }
+  guint64 get_steps_up() const { return steps_up; }
+
+  static char const *level_name(TweakQualityLevel level);
+
+ private:
+  void set_level(TweakQualityLevel new_level, gint64 duration_us);
+
+  gboolean enabled = false;
+  gint64 budget_us = 2000;
+  TweakQualityLevel level = TWEAKS_QUALITY_FULL;
+  guint over = 0;   // consecutive passes over the budget
+  guint under = 0;  // consecutive passes under half the budget
+  guint64 steps_down = 0;
+  guint64 steps_up = 0;
+};
@@ -0,0 +1,338 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// Offline replay of event traces dumped by the plugin.
+//
+// usage: xi-tweaks-replay [--list] trace-file
+//
+// Events are fed through trace_event_schedules_pass() with the same
+// coalescing as the plugin: requests made while a pass is pending merge
+// into it.  Recorded pass boundaries stand in for main loop iterations.
+//
+// Each replayed pass is costed again rather than read back: a model of the
+// highlight pass tracks the dirty notebooks, their recorded page counts and
+// current pages, and the styles already written, then counts the pages a
+// pass would visit and the writes it would make.  Notebooks are modelled
+// by kind, so several "other" notebooks count as one.
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "trace.h"
+
+static char const *notebook_names[] = {"sidebar", "msgwin", "editor",
+                                       "other"};
+
+static char const *notebook_name(uint8_t kind) {
+  return kind < 4 ? notebook_names[kind] : "unknown";
+}
+
+// What a pass knows of one notebook kind.
+struct ModelNotebook {
+  bool seen = false;
+  bool dirty = false;
+  uint32_t pages = 0;     // latest recorded page count
+  int32_t current = -1;   // latest recorded current page
+  uint32_t styled = 0;    // leading pages whose style has been written
+  int32_t focus = -1;     // page carrying the focus style
+};
+
+struct PassModel {
+  ModelNotebook notebooks[4];
+  int focused = -1;  // kind with focus after the last pass
+  uint64_t pages = 0;
+  uint64_t writes = 0;
+
+  void mark_dirty(uint8_t kind) {
+    if (kind < 4) {
+      notebooks[kind].dirty = true;
+    }
+  }
+
+  void mark_all_dirty() {
+    for (ModelNotebook &nb : notebooks) {
+      nb.dirty = nb.seen;
+    }
+  }
+
+  void set_state(uint8_t kind, uint16_t current, uint32_t pages) {
+    if (kind < 4) {
+      ModelNotebook &nb = notebooks[kind];
+      nb.seen = true;
+      nb.pages = pages;
+      nb.current = current == TWEAKS_TRACE_NO_PAGE ? -1 : current;
+    }
+  }
+
+  // Mirrors notebook_focus_highlight() at full quality: every page of a
+  // dirty notebook is visited, and only tabs and pages whose state changes
+  // are written.
+  void pass(uint8_t focus_kind) {
+    // focus may have left a notebook without it emitting anything
+    mark_dirty(uint8_t(focused));
+    mark_dirty(focus_kind);
+    focused = focus_kind < 4 ? focus_kind : -1;
+
+    for (int kind = 0; kind < 4; kind++) {
+      ModelNotebook &nb = notebooks[kind];
+      if (!nb.dirty || !nb.seen) {
+        continue;
+      }
+      nb.dirty = false;
+      pages += nb.pages;
+
+      // previously unnamed pages get their tab and page styled once
+      uint32_t styled = std::min(nb.styled, nb.pages);
+      writes += 2 * (nb.pages - styled);
+      nb.styled = nb.pages;
+
+      int32_t focus = kind == focused ? nb.current : -1;
+      if (nb.focus != focus) {
+        writes += nb.focus >= 0 && uint32_t(nb.focus) < styled ? 2 : 0;
+        writes += focus >= 0 && uint32_t(focus) < styled ? 2 : 0;
+        nb.focus = focus;
+      }
+    }
+  }
+};
+
+static bool read_trace(char const *filename,
+                       std::vector<TweakTraceRecord> &records) {
+  FILE *fp = fopen(filename, "rb");
+  if (fp == nullptr) {
+    fprintf(stderr, "%s: cannot open\n", filename);
+    return false;
+  }
+
+  TweakTraceHeader header;
+  if (fread(&header, sizeof(header), 1, fp) != 1 ||
+      memcmp(header.magic, TWEAKS_TRACE_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != TWEAKS_TRACE_VERSION ||
+      header.record_size != sizeof(TweakTraceRecord)) {
+    fprintf(stderr, "%s: not a trace file\n", filename);
+    fclose(fp);
+    return false;
+  }
+
+  // a corrupt count must not size the allocation
+  struct stat st;
+  uint64_t available = 0;
+  if (fstat(fileno(fp), &st) == 0 && uint64_t(st.st_size) > sizeof(header)) {
+    available = (st.st_size - sizeof(header)) / sizeof(TweakTraceRecord);
+  }
+  if (header.count > available) {
+    fprintf(stderr, "%s: header claims %llu records, file holds %llu\n",
+            filename, (unsigned long long)header.count,
+            (unsigned long long)available);
+  }
+
+  records.resize(std::min(header.count, available));
+  size_t count = fread(records.data(), sizeof(TweakTraceRecord),
+                       records.size(), fp);
+  if (count != records.size()) {
+    fprintf(stderr, "%s: truncated after %zu records\n", filename, count);
+    records.resize(count);
+  }
+
+  fclose(fp);
+  return true;
+}
+
+static void list_trace(std::vector<TweakTraceRecord> const &records) {
+  uint64_t start = records.empty() ? 0 : records.front().time_us;
+
+  for (TweakTraceRecord const &rec : records) {
+    TweakTraceType type = TweakTraceType(rec.type);
+    printf("%12.3f ms  %-13s %-8s ", (rec.time_us - start) / 1000.0,
+           trace_type_name(type),
+           type == TWEAKS_TRACE_PASS_END ? "" : notebook_name(rec.notebook));
+
+    switch (type) {
+      case TWEAKS_TRACE_SIGNAL:
+        printf("%s\n", trace_signal_name(TweakSignalKind(rec.code)));
+        break;
+      case TWEAKS_TRACE_EDITOR_NOTIFY:
+        printf("code %u\n", rec.code);
+        break;
+      case TWEAKS_TRACE_PASS_BEGIN:
+        printf("%u notebooks\n", rec.value);
+        break;
+      case TWEAKS_TRACE_PASS_END:
+        printf("%u pages, %u writes, focus %s\n", rec.code, rec.value,
+               rec.notebook == TWEAKS_TRACE_NO_FOCUS
+                   ? "none"
+                   : notebook_name(rec.notebook));
+        break;
+      case TWEAKS_TRACE_NOTEBOOK:
+        if (rec.code == TWEAKS_TRACE_NO_PAGE) {
+          printf("%u pages, none current\n", rec.value);
+        } else {
+          printf("%u pages, current %u\n", rec.value, rec.code);
+        }
+        break;
+      default:
+        printf("\n");
+        break;
+    }
+  }
+}
+
+static uint64_t percentile(std::vector<uint64_t> const &sorted, double p) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  size_t index = size_t(p * (sorted.size() - 1) + 0.5);
+  return sorted[std::min(index, sorted.size() - 1)];
+}
+
+static void replay_trace(std::vector<TweakTraceRecord> const &records) {
+  uint64_t events[TWEAKS_TRACE_TYPE_COUNT] = {};
+  uint64_t signals[TWEAKS_SIGNAL_COUNT] = {};
+  uint64_t scheduled = 0, coalesced = 0, ignored = 0;
+  uint64_t recorded_passes = 0, passes = 0, skipped_passes = 0;
+  uint64_t recorded_pages = 0, recorded_writes = 0;
+  PassModel model;
+  std::vector<uint64_t> latency;
+  std::vector<uint64_t> duration;
+
+  bool pending = false;
+  bool in_pass = false;
+  uint64_t pending_since = 0;
+  uint64_t pass_begin = 0;
+
+  for (TweakTraceRecord const &rec : records) {
+    TweakTraceType type = TweakTraceType(rec.type);
+    if (type < TWEAKS_TRACE_TYPE_COUNT) {
+      events[type]++;
+    }
+
+    switch (type) {
+      case TWEAKS_TRACE_SIGNAL:
+        if (rec.code < TWEAKS_SIGNAL_COUNT) {
+          signals[rec.code]++;
+        }
+        // fallthrough
+      case TWEAKS_TRACE_EDITOR_NOTIFY:
+        if (!trace_event_schedules_pass(type, rec.code)) {
+          ignored++;
+          break;
+        }
+        model.mark_dirty(rec.notebook);
+        if (pending) {
+          coalesced++;
+        } else {
+          scheduled++;
+          pending = true;
+          pending_since = rec.time_us;
+        }
+        break;
+
+      case TWEAKS_TRACE_PASS_BEGIN:
+        recorded_passes++;
+        in_pass = pending;
+        pass_begin = rec.time_us;
+        if (!pending) {
+          skipped_passes++;
+        }
+        break;
+
+      case TWEAKS_TRACE_NOTEBOOK:
+        model.set_state(rec.notebook, rec.code, rec.value);
+        break;
+
+      case TWEAKS_TRACE_DIRTY_ALL:
+        model.mark_all_dirty();
+        break;
+
+      case TWEAKS_TRACE_PASS_END:
+        if (in_pass) {
+          passes++;
+          model.pass(rec.notebook);
+          recorded_pages += rec.code;
+          recorded_writes += rec.value;
+          latency.push_back(rec.time_us - pending_since);
+          duration.push_back(rec.time_us - pass_begin);
+          pending = false;
+          in_pass = false;
+        }
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  std::sort(latency.begin(), latency.end());
+  std::sort(duration.begin(), duration.end());
+
+  uint64_t span = records.size() < 2
+                      ? 0
+                      : records.back().time_us - records.front().time_us;
+
+  printf("records:          %zu over %.3f s\n", records.size(), span / 1e6);
+  for (int i = 0; i < TWEAKS_TRACE_TYPE_COUNT; i++) {
+    printf("  %-16s %llu\n", trace_type_name(TweakTraceType(i)),
+           (unsigned long long)events[i]);
+  }
+  for (int i = 0; i < TWEAKS_SIGNAL_COUNT; i++) {
+    if (signals[i] != 0) {
+      printf("    %-20s %llu\n", trace_signal_name(TweakSignalKind(i)),
+             (unsigned long long)signals[i]);
+    }
+  }
+  printf("requests:         %llu scheduled, %llu coalesced, %llu ignored\n",
+         (unsigned long long)scheduled, (unsigned long long)coalesced,
+         (unsigned long long)ignored);
+  printf("passes:           %llu replayed, %llu recorded, %llu avoidable\n",
+         (unsigned long long)passes, (unsigned long long)recorded_passes,
+         (unsigned long long)skipped_passes);
+  printf("pages visited:    %llu modelled, %llu recorded\n",
+         (unsigned long long)model.pages, (unsigned long long)recorded_pages);
+  printf("style writes:     %llu modelled, %llu recorded\n",
+         (unsigned long long)model.writes,
+         (unsigned long long)recorded_writes);
+  printf("latency (us):     p50 %llu  p95 %llu  p99 %llu  max %llu\n",
+         (unsigned long long)percentile(latency, 0.50),
+         (unsigned long long)percentile(latency, 0.95),
+         (unsigned long long)percentile(latency, 0.99),
+         (unsigned long long)percentile(latency, 1.0));
+  printf("pass time (us):   p50 %llu  p95 %llu  p99 %llu  max %llu\n",
+         (unsigned long long)percentile(duration, 0.50),
+         (unsigned long long)percentile(duration, 0.95),
+         (unsigned long long)percentile(duration, 0.99),
+         (unsigned long long)percentile(duration, 1.0));
+}
+
+int main(int argc, char **argv) {
+  bool list = false;
+  char const *filename = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--list") == 0) {
+      list = true;
+    } else {
+      filename = argv[i];
+    }
+  }
+
+  if (filename == nullptr) {
+    fprintf(stderr, "usage: %s [--list] trace-file\n", argv[0]);
+    return 2;
+  }
+
+  std::vector<TweakTraceRecord> records;
+  if (!read_trace(filename, records)) {
+    return 1;
+  }
+
+  if (list) {
+    list_trace(records);
+  } else {
+    replay_trace(records);
+  }
+
+  return 0;
+}
@@ -0,0 +1,201 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "scheduler.h"
+
+// Global Variables
+TweakScheduler scheduler;
+
+static gint const source_priorities[TWEAKS_PRIORITY_COUNT] = {
+    G_PRIORITY_HIGH_IDLE,
+    G_PRIORITY_DEFAULT_IDLE,
+    G_PRIORITY_LOW,
+};
+
+static GSourceFuncs source_funcs = {
+    nullptr,
+    nullptr,
+    TweakScheduler::source_dispatch,
+    nullptr,
+};
+
+// Functions
+
+void TweakScheduler::add(TweakTaskKey key, TweakTaskPriority priority,
+                         GSourceFunc func, gpointer user_data) {
+  Task &task = tasks[key];
+
+  stats.scheduled++;
+
+  if (task.pending) {
+    // keep the original place in the queue, but never lower the priority
+    stats.coalesced++;
+    task.func = func;
+    task.user_data = user_data;
+    if (priority < task.priority) {
+      task.priority = priority;
+    }
+  } else {
+    task.func = func;
+    task.user_data = user_data;
+    task.priority = priority;
+    task.seq = ++seq;
+    task.pending = true;
+
+    stats.depth++;
+    if (stats.depth > stats.max_depth) {
+      stats.max_depth = stats.depth;
+    }
+  }
+
+  wake_source();
+}
+
+void TweakScheduler::cancel(TweakTaskKey key) {
+  Task &task = tasks[key];
+
+  if (task.pending) {
+    task = Task();
+    stats.depth--;
+  }
+
+  if (stats.depth == 0 && source != nullptr) {
+    g_source_set_ready_time(source, -1);
+  }
+}
+
+void TweakScheduler::cancel_all() {
+  for (Task &task : tasks) {
+    task = Task();
+  }
+  stats.depth = 0;
+
+  if (source != nullptr) {
+    g_source_destroy(source);
+    g_source_unref(source);
+    source = nullptr;
+  }
+}
+
+gboolean TweakScheduler::is_pending(TweakTaskKey key) const {
+  return tasks[key].pending;
+}
+
+double TweakScheduler::get_coalesce_ratio() const {
+  if (stats.scheduled == 0) {
+    return 0.0;
+  }
+  return double(stats.coalesced) / double(stats.scheduled);
+}
+
+void TweakScheduler::reset_stats() {
+  guint depth = stats.depth;
+  stats = TweakSchedulerStats();
+  stats.depth = depth;
+  stats.max_depth = depth;
+}
+
+TweakTaskPriority TweakScheduler::pending_priority() const {
+  TweakTaskPriority priority = TWEAKS_PRIORITY_LOW;
+  for (Task const &task : tasks) {
+    if (task.pending && task.priority < priority) {
+      priority = task.priority;
+    }
+  }
+  return priority;
+}
+
+void TweakScheduler::wake_source() {
+  TweakTaskPriority priority = pending_priority();
+
+  if (source == nullptr) {
+    source = g_source_new(&source_funcs, sizeof(GSource));
+    g_source_set_name(source, "xitweaks-scheduler");
+    g_source_set_callback(source, dispatch, this, nullptr);
+    g_source_set_priority(source, source_priorities[priority]);
+    g_source_attach(source, nullptr);
+    source_priority = priority;
+  } else if (priority != source_priority) {
+    g_source_set_priority(source, source_priorities[priority]);
+    source_priority = priority;
+  }
+
+  g_source_set_ready_time(source, 0);
+}
+
+gboolean TweakScheduler::source_dispatch(GSource *source, GSourceFunc callback,
+                                         gpointer user_data) {
+  return callback(user_data);
+}
+
+gboolean TweakScheduler::dispatch(gpointer user_data) {
+  return static_cast<TweakScheduler *>(user_data)->run_batch();
+}
+
+// Highest priority class first, then first come first served.  Tasks
+// added while the batch runs wait for the next batch, and tasks of a class
+// below the batch's own wait for a dispatch at their priority.
+int TweakScheduler::next_task(guint64 seq_limit,
+                              TweakTaskPriority priority_limit) const {
+  int next = -1;
+
+  for (int i = 0; i < TWEAKS_TASK_COUNT; i++) {
+    Task const &task = tasks[i];
+    if (!task.pending || task.seq > seq_limit ||
+        task.priority > priority_limit) {
+      continue;
+    }
+    if (next < 0 || task.priority < tasks[next].priority ||
+        (task.priority == tasks[next].priority && task.seq < tasks[next].seq)) {
+      next = i;
+    }
+  }
+
+  return next;
+}
+
+gboolean TweakScheduler::run_batch() {
+  gint64 start = g_get_monotonic_time();
+  guint64 seq_limit = seq;
+  TweakTaskPriority priority_limit = source_priority;
+  GSource *current = source;
+
+  stats.batches++;
+
+  int i;
+  while ((i = next_task(seq_limit, priority_limit)) >= 0) {
+    Task &task = tasks[i];
+    GSourceFunc func = task.func;
+    gpointer user_data = task.user_data;
+
+    task.pending = false;
+    stats.depth--;
+    stats.executed++;
+
+    // a task returning true is queued again for the next batch
+    if (func != nullptr && func(user_data) && !task.pending) {
+      task.seq = ++seq;
+      task.pending = true;
+      stats.depth++;
+    }
+
+    if (g_get_monotonic_time() - start >= budget_us &&
+        next_task(seq_limit, priority_limit) >= 0) {
+      stats.over_budget++;
+      break;
+    }
+  }
+
+  // a task cancelled everything while the batch ran
+  if (source != current) {
+    return false;
+  }
+
+  if (stats.depth == 0) {
+    g_source_set_ready_time(source, -1);
+    return true;
+  }
+
+  // lower classes run from a later dispatch, after GTK's redraw
+  wake_source();
+  return true;
+}
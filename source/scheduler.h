@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "plugin.h"
+
+// Deferred tasks are coalesced by key; at most one of each is pending.
+enum TweakTaskKey {
+  TWEAKS_TASK_HIGHLIGHT,
+  TWEAKS_TASK_RELOAD_CONFIG,
+  TWEAKS_TASK_SAVE_SETTINGS,
+  TWEAKS_TASK_BULK_LOAD_END,
+
+  TWEAKS_TASK_COUNT,
+};
+
+enum TweakTaskPriority {
+  TWEAKS_PRIORITY_HIGH,     // runs before GTK resize and redraw
+  TWEAKS_PRIORITY_DEFAULT,  // runs with ordinary idle handlers
+  TWEAKS_PRIORITY_LOW,      // runs after everything else settles
+
+  TWEAKS_PRIORITY_COUNT,
+};
+
+struct TweakSchedulerStats {
+  guint64 scheduled = 0;    // calls to add()
+  guint64 coalesced = 0;    // calls to add() merged into a pending task
+  guint64 executed = 0;     // task functions run
+  guint64 batches = 0;      // main loop dispatches
+  guint64 over_budget = 0;  // batches cut short by the time budget
+  guint depth = 0;          // tasks currently pending
+  guint max_depth = 0;
+};
+
+class TweakScheduler {
+ public:
+  static gboolean source_dispatch(GSource *source, GSourceFunc callback,
+                                  gpointer user_data);
+
+  TweakScheduler() = default;
+  ~TweakScheduler() { cancel_all(); }
+
+  void add(TweakTaskKey key, TweakTaskPriority priority, GSourceFunc func,
+           gpointer user_data = nullptr);
+  void cancel(TweakTaskKey key);
+  void cancel_all();
+  gboolean is_pending(TweakTaskKey key) const;
+
+  TweakSchedulerStats const &get_stats() const { return stats; }
+  double get_coalesce_ratio() const;
+  void reset_stats();
+
+ public:
+  // Time budget for one batch, in microseconds.  Remaining tasks are
+  // carried over to the next main loop iteration.
+  gint64 budget_us = 4000;
+
+ private:
+  struct Task {
+    GSourceFunc func = nullptr;
+    gpointer user_data = nullptr;
+    TweakTaskPriority priority = TWEAKS_PRIORITY_DEFAULT;
+    guint64 seq = 0;
+    gboolean pending = false;
+  };
+
+  static gboolean dispatch(gpointer user_data);
+  gboolean run_batch();
+  int next_task(guint64 seq_limit, TweakTaskPriority priority_limit) const;
+  TweakTaskPriority pending_priority() const;
+  void wake_source();
+
+  Task tasks[TWEAKS_TASK_COUNT];
+  guint64 seq = 0;
+
+  // Created on first use and kept until cancel_all(), so scheduling
+  // only toggles its ready time and never allocates.
+  GSource *source = nullptr;
+  TweakTaskPriority source_priority = TWEAKS_PRIORITY_LOW;
+  TweakSchedulerStats stats;
+};
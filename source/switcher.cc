@@ -0,0 +1,385 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "switcher.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "auxiliary.h"
+
+// Global Variables
+TweakSwitcher switcher;
+
+enum {
+  SWITCHER_COLUMN_NAME,
+  SWITCHER_COLUMN_PATH,
+  SWITCHER_COLUMN_INDEX,
+  SWITCHER_COLUMN_COUNT,
+};
+
+// One bit per character, folded to 64.  Collisions only weaken the filter;
+// an entry missing any bit of the query cannot match it.
+static guint64 char_mask(std::string const &text) {
+  guint64 mask = 0;
+  for (char c : text) {
+    mask |= guint64(1) << (guchar(c) & 63);
+  }
+  return mask;
+}
+
+// Greedy subsequence match.  Consecutive characters and characters at the
+// start of a word score higher.  Returns -1 if there is no match.
+static int fuzzy_score(std::string const &query, std::string const &text) {
+  int score = 0;
+  size_t pos = 0;
+  size_t last = std::string::npos;
+
+  for (char q : query) {
+    size_t found = text.find(q, pos);
+    if (found == std::string::npos) {
+      return -1;
+    }
+
+    score += 1;
+    if (last != std::string::npos && found == last + 1) {
+      score += 4;
+    }
+    if (found == 0 || strchr("/\\._- ", text[found - 1]) != nullptr) {
+      score += 6;
+    }
+
+    last = found;
+    pos = found + 1;
+  }
+
+  // prefer shorter texts among equal matches
+  return score * 64 - int(MIN(text.size(), 63));
+}
+
+static void set_entry_text(TweakSwitchEntry &entry, std::string const &name,
+                           std::string const &path) {
+  entry.name = name;
+  entry.path = path;
+  entry.key_name = to_lower(name);
+  entry.key_path = to_lower(path);
+  entry.chars = char_mask(entry.key_path) | char_mask(entry.key_name);
+}
+
+// Functions
+
+// also called after a rename
+void TweakSwitcher::add_document(GeanyDocument *doc) {
+  if (!DOC_VALID(doc)) {
+    return;
+  }
+
+  auto it = positions.find(doc->id);
+  if (it == positions.end()) {
+    it = positions.emplace(doc->id, docs.size()).first;
+    docs.emplace_back();
+  }
+
+  TweakSwitchEntry &entry = docs[it->second];
+  entry.kind = TWEAKS_SWITCH_DOCUMENT;
+  entry.doc_id = doc->id;
+
+  std::string path = DOC_FILENAME(doc);
+  if (entry.path != path) {
+    set_entry_text(entry, cstr_assign(g_path_get_basename(path.c_str())),
+                   path);
+  }
+
+  if (window != nullptr) {
+    refresh();
+  }
+}
+
+void TweakSwitcher::remove_document(GeanyDocument *doc) {
+  if (doc == nullptr) {
+    return;
+  }
+
+  auto it = positions.find(doc->id);
+  if (it == positions.end()) {
+    return;
+  }
+
+  size_t index = it->second;
+  positions.erase(it);
+
+  if (index != docs.size() - 1) {
+    docs[index] = std::move(docs.back());
+    positions[docs[index].doc_id] = index;
+  }
+  docs.pop_back();
+
+  if (window != nullptr) {
+    refresh();
+  }
+}
+
+void TweakSwitcher::clear() {
+  hide();
+  docs.clear();
+  positions.clear();
+  pages.clear();
+}
+
+void TweakSwitcher::show(GtkWindow *parent, GtkNotebook *sidebar,
+                         GtkNotebook *msgwin) {
+  if (window != nullptr) {
+    gtk_window_present(GTK_WINDOW(window));
+    return;
+  }
+
+  pages.clear();
+  add_pages(sidebar, TWEAKS_SWITCH_SIDEBAR, "Sidebar");
+  add_pages(msgwin, TWEAKS_SWITCH_MSGWIN, "Message Window");
+
+  window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+  gtk_window_set_transient_for(GTK_WINDOW(window), parent);
+  gtk_window_set_destroy_with_parent(GTK_WINDOW(window), true);
+  gtk_window_set_modal(GTK_WINDOW(window), true);
+  gtk_window_set_decorated(GTK_WINDOW(window), false);
+  gtk_window_set_skip_taskbar_hint(GTK_WINDOW(window), true);
+  gtk_window_set_position(GTK_WINDOW(window), GTK_WIN_POS_CENTER_ON_PARENT);
+  gtk_window_set_default_size(GTK_WINDOW(window), 600, 400);
+  gtk_widget_set_name(window, "geany-xitweaks-switcher");
+
+  GtkWidget *box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 3);
+  gtk_container_add(GTK_CONTAINER(window), box);
+
+  entry = gtk_entry_new();
+  gtk_box_pack_start(GTK_BOX(box), entry, false, false, 0);
+
+  store = gtk_list_store_new(SWITCHER_COLUMN_COUNT, G_TYPE_STRING,
+                             G_TYPE_STRING, G_TYPE_UINT);
+  view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(store));
+  g_object_unref(store);
+  gtk_tree_view_set_headers_visible(GTK_TREE_VIEW(view), false);
+  gtk_tree_view_insert_column_with_attributes(
+      GTK_TREE_VIEW(view), -1, nullptr, gtk_cell_renderer_text_new(), "text",
+      SWITCHER_COLUMN_NAME, nullptr);
+  gtk_tree_view_insert_column_with_attributes(
+      GTK_TREE_VIEW(view), -1, nullptr, gtk_cell_renderer_text_new(), "text",
+      SWITCHER_COLUMN_PATH, nullptr);
+
+  GtkWidget *scroll = gtk_scrolled_window_new(nullptr, nullptr);
+  gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scroll),
+                                 GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+  gtk_container_add(GTK_CONTAINER(scroll), view);
+  gtk_box_pack_start(GTK_BOX(box), scroll, true, true, 0);
+
+  g_signal_connect(entry, "changed", G_CALLBACK(on_changed), this);
+  g_signal_connect(entry, "activate", G_CALLBACK(on_activate), this);
+  g_signal_connect(entry, "key-press-event", G_CALLBACK(on_key_press), this);
+  g_signal_connect(view, "row-activated", G_CALLBACK(on_row_activated), this);
+  g_signal_connect(window, "focus-out-event", G_CALLBACK(on_focus_out), this);
+
+  refresh();
+
+  gtk_widget_show_all(window);
+  gtk_widget_grab_focus(entry);
+}
+
+void TweakSwitcher::hide() {
+  if (window == nullptr) {
+    return;
+  }
+
+  GtkWidget *w = window;
+  window = nullptr;
+  entry = nullptr;
+  view = nullptr;
+  store = nullptr;
+  ranked.clear();
+
+  gtk_widget_destroy(w);
+}
+
+void TweakSwitcher::on_changed(GtkEntry *entry, gpointer user_data) {
+  static_cast<TweakSwitcher *>(user_data)->refresh();
+}
+
+void TweakSwitcher::on_activate(GtkEntry *entry, gpointer user_data) {
+  auto *self = static_cast<TweakSwitcher *>(user_data);
+  GtkTreeIter iter;
+
+  GtkTreeSelection *selection =
+      gtk_tree_view_get_selection(GTK_TREE_VIEW(self->view));
+  if (gtk_tree_selection_get_selected(selection, nullptr, &iter)) {
+    self->select(&iter);
+  }
+}
+
+gboolean TweakSwitcher::on_key_press(GtkWidget *widget, GdkEventKey *event,
+                                     gpointer user_data) {
+  auto *self = static_cast<TweakSwitcher *>(user_data);
+
+  switch (event->keyval) {
+    case GDK_KEY_Escape:
+      self->hide();
+      return true;
+    case GDK_KEY_Up:
+      self->move_cursor(false);
+      return true;
+    case GDK_KEY_Down:
+      self->move_cursor(true);
+      return true;
+    default:
+      return false;
+  }
+}
+
+gboolean TweakSwitcher::on_focus_out(GtkWidget *widget, GdkEvent *event,
+                                     gpointer user_data) {
+  static_cast<TweakSwitcher *>(user_data)->hide();
+  return false;
+}
+
+void TweakSwitcher::on_row_activated(GtkTreeView *view, GtkTreePath *path,
+                                     GtkTreeViewColumn *column,
+                                     gpointer user_data) {
+  auto *self = static_cast<TweakSwitcher *>(user_data);
+  GtkTreeIter iter;
+
+  if (gtk_tree_model_get_iter(GTK_TREE_MODEL(self->store), &iter, path)) {
+    self->select(&iter);
+  }
+}
+
+void TweakSwitcher::add_pages(GtkNotebook *notebook, TweakSwitchKind kind,
+                              char const *where) {
+  gint num_pages = gtk_notebook_get_n_pages(notebook);
+
+  for (int i = 0; i < num_pages; i++) {
+    GtkWidget *page = gtk_notebook_get_nth_page(notebook, i);
+    char const *text = gtk_notebook_get_tab_label_text(notebook, page);
+    if (text == nullptr || !gtk_widget_get_visible(page)) {
+      continue;
+    }
+
+    TweakSwitchEntry entry;
+    entry.kind = kind;
+    entry.notebook = notebook;
+    entry.page = page;
+    set_entry_text(entry, text, where);
+    pages.push_back(entry);
+  }
+}
+
+// Scores every candidate that passes the character filter, then sorts only
+// the best few.
+void TweakSwitcher::refresh() {
+  std::string query = to_lower(gtk_entry_get_text(GTK_ENTRY(entry)));
+  query.erase(std::remove(query.begin(), query.end(), ' '), query.end());
+  guint64 query_chars = char_mask(query);
+
+  guint count = docs.size() + pages.size();
+  ranked.clear();
+  ranked.reserve(count);
+
+  for (guint i = 0; i < count; i++) {
+    TweakSwitchEntry const &candidate = get_entry(i);
+    if ((candidate.chars & query_chars) != query_chars) {
+      continue;
+    }
+
+    // a match in the name outranks one that needs the directories
+    int score = fuzzy_score(query, candidate.key_name);
+    if (score >= 0) {
+      score *= 2;
+    } else {
+      score = fuzzy_score(query, candidate.key_path);
+    }
+    if (score >= 0) {
+      ranked.emplace_back(score, i);
+    }
+  }
+
+  auto last = ranked.begin() + MIN(ranked.size(), TWEAKS_SWITCHER_RESULTS);
+  std::partial_sort(ranked.begin(), last, ranked.end(),
+                    [](std::pair<int, guint> const &a,
+                       std::pair<int, guint> const &b) {
+                      return a.first > b.first;
+                    });
+
+  gtk_list_store_clear(store);
+  for (auto it = ranked.begin(); it != last; ++it) {
+    TweakSwitchEntry const &candidate = get_entry(it->second);
+    gtk_list_store_insert_with_values(
+        store, nullptr, -1, SWITCHER_COLUMN_NAME, candidate.name.c_str(),
+        SWITCHER_COLUMN_PATH, candidate.path.c_str(), SWITCHER_COLUMN_INDEX,
+        it->second, -1);
+  }
+
+  GtkTreeIter iter;
+  if (gtk_tree_model_get_iter_first(GTK_TREE_MODEL(store), &iter)) {
+    gtk_tree_selection_select_iter(
+        gtk_tree_view_get_selection(GTK_TREE_VIEW(view)), &iter);
+  }
+}
+
+// Switches to the chosen page and hands its notebook straight to the focus
+// highlight instead of waiting for GTK focus signals.
+void TweakSwitcher::select(GtkTreeIter *iter) {
+  guint index = 0;
+  gtk_tree_model_get(GTK_TREE_MODEL(store), iter, SWITCHER_COLUMN_INDEX,
+                     &index, -1);
+  TweakSwitchEntry target = get_entry(index);
+
+  hide();
+
+  if (target.kind == TWEAKS_SWITCH_DOCUMENT) {
+    GeanyDocument *doc = document_find_by_id(target.doc_id);
+    if (!DOC_VALID(doc)) {
+      return;
+    }
+
+    GtkNotebook *nb = GTK_NOTEBOOK(geany_data->main_widgets->notebook);
+    gtk_notebook_set_current_page(nb, document_get_notebook_page(doc));
+    gtk_widget_grab_focus(GTK_WIDGET(doc->editor->sci));
+    notebook_focus_schedule(nb);
+  } else {
+    gint page_num = gtk_notebook_page_num(target.notebook, target.page);
+    if (page_num < 0) {
+      return;
+    }
+
+    gtk_notebook_set_current_page(target.notebook, page_num);
+    GtkWidget *focus = find_focus_widget(target.page);
+    if (focus != nullptr) {
+      gtk_widget_grab_focus(focus);
+    }
+    notebook_focus_schedule(target.notebook);
+  }
+}
+
+void TweakSwitcher::move_cursor(gboolean down) {
+  GtkTreeModel *model = GTK_TREE_MODEL(store);
+  GtkTreeSelection *selection =
+      gtk_tree_view_get_selection(GTK_TREE_VIEW(view));
+  GtkTreeIter iter;
+
+  if (!gtk_tree_selection_get_selected(selection, nullptr, &iter)) {
+    return;
+  }
+
+  gboolean moved = down ? gtk_tree_model_iter_next(model, &iter)
+                        : gtk_tree_model_iter_previous(model, &iter);
+  if (moved) {
+    gtk_tree_selection_select_iter(selection, &iter);
+
+    GtkTreePath *path = gtk_tree_model_get_path(model, &iter);
+    gtk_tree_view_scroll_to_cell(GTK_TREE_VIEW(view), path, nullptr, false, 0,
+                                 0);
+    gtk_tree_path_free(path);
+  }
+}
+
+TweakSwitchEntry const &TweakSwitcher::get_entry(guint index) const {
+  if (index < docs.size()) {
+    return docs[index];
+  }
+  return pages[index - docs.size()];
+}
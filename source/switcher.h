@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "plugin.h"
+
+// results shown for a query
+#define TWEAKS_SWITCHER_RESULTS 50
+
+enum TweakSwitchKind {
+  TWEAKS_SWITCH_DOCUMENT,
+  TWEAKS_SWITCH_SIDEBAR,
+  TWEAKS_SWITCH_MSGWIN,
+};
+
+struct TweakSwitchEntry {
+  TweakSwitchKind kind = TWEAKS_SWITCH_DOCUMENT;
+  guint doc_id = 0;                 // documents
+  GtkNotebook *notebook = nullptr;  // sidebar and msgwin pages
+  GtkWidget *page = nullptr;
+
+  std::string name;  // as shown
+  std::string path;
+  std::string key_name;  // lowercase, for matching
+  std::string key_path;
+  guint64 chars = 0;  // characters present, to reject most entries early
+};
+
+// Popup to jump to an open document, sidebar page, or msgwin tab by fuzzy
+// name.  Documents are indexed as they are opened, renamed, and closed;
+// the few notebook pages are indexed when the popup opens.
+class TweakSwitcher {
+ public:
+  TweakSwitcher() = default;
+
+  void add_document(GeanyDocument *doc);
+  void remove_document(GeanyDocument *doc);
+  void clear();
+
+  void show(GtkWindow *parent, GtkNotebook *sidebar, GtkNotebook *msgwin);
+  void hide();
+
+ private:
+  static void on_changed(GtkEntry *entry, gpointer user_data);
+  static void on_activate(GtkEntry *entry, gpointer user_data);
+  static gboolean on_key_press(GtkWidget *widget, GdkEventKey *event,
+                               gpointer user_data);
+  static gboolean on_focus_out(GtkWidget *widget, GdkEvent *event,
+                               gpointer user_data);
+  static void on_row_activated(GtkTreeView *view, GtkTreePath *path,
+                               GtkTreeViewColumn *column, gpointer user_data);
+
+  void add_pages(GtkNotebook *notebook, TweakSwitchKind kind,
+                 char const *where);
+  void refresh();
+  void select(GtkTreeIter *iter);
+  void move_cursor(gboolean down);
+  TweakSwitchEntry const &get_entry(guint index) const;
+
+  std::vector<TweakSwitchEntry> docs;  // unordered, removed by swap
+  std::unordered_map<guint, size_t> positions;  // document id to index
+  std::vector<TweakSwitchEntry> pages;
+
+  std::vector<std::pair<int, guint>> ranked;  // score and entry index
+
+  GtkWidget *window = nullptr;
+  GtkWidget *entry = nullptr;
+  GtkWidget *view = nullptr;
+  GtkListStore *store = nullptr;
+};
@@ -0,0 +1,235 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "tabrules.h"
+
+#include <cstring>
+
+// Global Variables
+TweakTabRules tabrules;
+
+// Functions
+
+void TweakTabRules::load(GKeyFile *kf) {
+  config_sources.clear();
+  read_sources(kf, TWEAKS_RULES_GROUP, "", config_sources);
+  compile();
+}
+
+// Returns whether the rules changed.  Passing nullptr removes project rules.
+gboolean TweakTabRules::set_project_rules(GKeyFile *kf, char const *group) {
+  Sources sources;
+  if (kf != nullptr) {
+    read_sources(kf, group, TWEAKS_RULES_PROJECT_PREFIX, sources);
+  }
+
+  if (sources == project_sources) {
+    return false;
+  }
+  project_sources = std::move(sources);
+  compile();
+  return true;
+}
+
+void TweakTabRules::clear() {
+  for (Glob &glob : globs) {
+    g_pattern_spec_free(glob.spec);
+  }
+  for (Regex &regex : regexes) {
+    g_regex_unref(regex.regex);
+  }
+
+  trie.clear();
+  extensions.clear();
+  globs.clear();
+  regexes.clear();
+  rule_count = 0;
+}
+
+void TweakTabRules::read_sources(GKeyFile *kf, char const *group,
+                                 char const *prefix, Sources &sources) {
+  if (!g_key_file_has_group(kf, group)) {
+    return;
+  }
+
+  gchar **keys = g_key_file_get_keys(kf, group, nullptr, nullptr);
+  for (gchar **key = keys; key != nullptr && *key != nullptr; key++) {
+    if (!g_str_has_prefix(*key, prefix)) {
+      continue;
+    }
+
+    gchar **patterns =
+        g_key_file_get_string_list(kf, group, *key, nullptr, nullptr);
+    for (gchar **p = patterns; p != nullptr && *p != nullptr; p++) {
+      if (**p != '\0') {
+        sources.emplace_back(*key + strlen(prefix), *p);
+      }
+    }
+    g_strfreev(patterns);
+  }
+  g_strfreev(keys);
+}
+
+void TweakTabRules::compile() {
+  clear();
+  generation++;
+
+  for (Sources const *sources : {&config_sources, &project_sources}) {
+    for (auto const &source : *sources) {
+      int bit = class_bit(source.first);
+      if (bit < 0) {
+        msgwin_status_add(
+            _("Xi/Tweaks: Too many tab styles; ignoring \"%s\"."),
+            source.first.c_str());
+        continue;
+      }
+      add_pattern(source.second.c_str(), guint64(1) << bit);
+    }
+  }
+}
+
+// rel_path is the path relative to the project base, if inside it
+guint64 TweakTabRules::match(char const *path, char const *rel_path) const {
+  if (path == nullptr || rule_count == 0) {
+    return 0;
+  }
+
+  guint64 mask = match_prefix(path);
+  if (rel_path != nullptr) {
+    mask |= match_prefix(rel_path);
+  }
+
+  char const *base = strrchr(path, G_DIR_SEPARATOR);
+  base = base != nullptr ? base + 1 : path;
+
+  if (!extensions.empty()) {
+    char const *dot = strrchr(base, '.');
+    if (dot != nullptr) {
+      auto it = extensions.find(dot + 1);
+      if (it != extensions.end()) {
+        mask |= it->second;
+      }
+    }
+  }
+
+  for (Glob const &glob : globs) {
+    if ((mask & glob.mask) == glob.mask) {
+      continue;
+    }
+    if (glob.full_path) {
+      if (g_pattern_match_string(glob.spec, path) ||
+          (rel_path != nullptr &&
+           g_pattern_match_string(glob.spec, rel_path))) {
+        mask |= glob.mask;
+      }
+    } else if (g_pattern_match_string(glob.spec, base)) {
+      mask |= glob.mask;
+    }
+  }
+
+  for (Regex const &regex : regexes) {
+    if ((mask & regex.mask) != regex.mask &&
+        g_regex_match(regex.regex, path, GRegexMatchFlags(0), nullptr)) {
+      mask |= regex.mask;
+    }
+  }
+
+  return mask;
+}
+
+// Patterns:
+//   re:<regex>  matched against the full path
+//   <dir>/      directory prefix, absolute or relative to the project base
+//   *.<ext>     file extension
+//   <glob>      file name, or full path if it contains a '/'
+void TweakTabRules::add_pattern(char const *pattern, guint64 mask) {
+  size_t len = strlen(pattern);
+  rule_count++;
+
+  if (g_str_has_prefix(pattern, "re:")) {
+    GError *error = nullptr;
+    GRegex *regex = g_regex_new(pattern + 3, G_REGEX_OPTIMIZE,
+                                GRegexMatchFlags(0), &error);
+    if (regex == nullptr) {
+      msgwin_status_add(_("Xi/Tweaks: Invalid tab style regex \"%s\": %s"),
+                        pattern + 3, error->message);
+      g_error_free(error);
+      rule_count--;
+      return;
+    }
+    regexes.push_back({regex, mask});
+  } else if (pattern[len - 1] == G_DIR_SEPARATOR) {
+    add_prefix(pattern, mask);
+  } else if (g_str_has_prefix(pattern, "*.") &&
+             strpbrk(pattern + 2, "*?/") == nullptr) {
+    extensions[pattern + 2] |= mask;
+  } else {
+    gboolean full_path = strchr(pattern, G_DIR_SEPARATOR) != nullptr;
+    globs.push_back({g_pattern_spec_new(pattern), full_path, mask});
+  }
+}
+
+void TweakTabRules::add_prefix(char const *prefix, guint64 mask) {
+  if (trie.empty()) {
+    trie.emplace_back();
+  }
+
+  guint32 node = 0;
+  for (char const *c = prefix; *c != '\0'; c++) {
+    guint32 next = 0;
+    for (auto const &child : trie[node].children) {
+      if (child.first == *c) {
+        next = child.second;
+        break;
+      }
+    }
+    if (next == 0) {
+      next = trie.size();
+      trie[node].children.emplace_back(*c, next);
+      trie.emplace_back();
+    }
+    node = next;
+  }
+
+  trie[node].mask |= mask;
+}
+
+guint64 TweakTabRules::match_prefix(char const *path) const {
+  if (trie.empty()) {
+    return 0;
+  }
+
+  guint64 mask = 0;
+  guint32 node = 0;
+  for (char const *c = path; *c != '\0'; c++) {
+    guint32 next = 0;
+    for (auto const &child : trie[node].children) {
+      if (child.first == *c) {
+        next = child.second;
+        break;
+      }
+    }
+    if (next == 0) {
+      break;
+    }
+    node = next;
+    mask |= trie[node].mask;
+  }
+
+  return mask;
+}
+
+int TweakTabRules::class_bit(std::string const &name) {
+  std::string cls = "xitweaks-tab-" + name;
+
+  for (size_t i = 0; i < classes.size(); i++) {
+    if (classes[i] == cls) {
+      return i;
+    }
+  }
+  if (classes.size() >= TWEAKS_RULES_MAX) {
+    return -1;
+  }
+
+  classes.push_back(cls);
+  return classes.size() - 1;
+}
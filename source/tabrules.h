@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "plugin.h"
+
+#define TWEAKS_RULES_GROUP "tab_styles"
+
+// one bit per style class
+#define TWEAKS_RULES_MAX 64
+
+// project keys in the [xitweaks] group that add tab style rules
+#define TWEAKS_RULES_PROJECT_PREFIX "tab_style_"
+
+// Rules from the [tab_styles] group and the open project, compiled once per
+// load: directory prefixes into a trie, "*.ext" globs into a hash, and the
+// rest into pattern specs and regexes.  Each class keeps its bit across
+// reloads, so classes already on a tab can still be removed by name.
+class TweakTabRules {
+ public:
+  TweakTabRules() = default;
+  ~TweakTabRules() { clear(); }
+
+  void load(GKeyFile *kf);
+  gboolean set_project_rules(GKeyFile *kf, char const *group);
+  void clear();
+
+  guint64 match(char const *path, char const *rel_path) const;
+
+  gboolean empty() const { return rule_count == 0; }
+  guint get_generation() const { return generation; }
+  char const *get_class(int bit) const { return classes[bit].c_str(); }
+
+ private:
+  struct TrieNode {
+    std::vector<std::pair<char, guint32>> children;
+    guint64 mask = 0;
+  };
+
+  struct Glob {
+    GPatternSpec *spec;
+    gboolean full_path;  // pattern has a '/'
+    guint64 mask;
+  };
+
+  struct Regex {
+    GRegex *regex;
+    guint64 mask;
+  };
+
+  typedef std::vector<std::pair<std::string, std::string>> Sources;
+
+  static void read_sources(GKeyFile *kf, char const *group,
+                           char const *prefix, Sources &sources);
+  void compile();
+  void add_pattern(char const *pattern, guint64 mask);
+  void add_prefix(char const *prefix, guint64 mask);
+  guint64 match_prefix(char const *path) const;
+  int class_bit(std::string const &name);
+
+  std::vector<TrieNode> trie;
+  std::unordered_map<std::string, guint64> extensions;
+  std::vector<Glob> globs;
+  std::vector<Regex> regexes;
+
+  Sources config_sources;  // class name and pattern
+  Sources project_sources;
+
+  std::vector<std::string> classes;
+  guint rule_count = 0;
+  guint generation = 0;
+};
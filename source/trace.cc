@@ -0,0 +1,105 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "trace.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+
+// Global Variables
+TweakTraceRecorder tracer;
+
+// Functions
+
+uint64_t TweakTraceRecorder::now_us() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void TweakTraceRecorder::record(TweakTraceType type, uint8_t notebook,
+                                uint16_t code, uint32_t value) {
+  uint64_t index = head++;
+  TweakTraceRecord &rec = records[index & (capacity - 1)];
+
+  rec.time_us = now_us();
+  rec.type = type;
+  rec.notebook = notebook;
+  rec.code = code;
+  rec.value = value;
+}
+
+bool TweakTraceRecorder::dump(char const *filename) const {
+  uint64_t end = head;
+  uint64_t begin = end > capacity ? end - capacity : 0;
+
+  FILE *fp = fopen(filename, "wb");
+  if (fp == nullptr) {
+    return false;
+  }
+
+  TweakTraceHeader header = {};
+  memcpy(header.magic, TWEAKS_TRACE_MAGIC, sizeof(header.magic));
+  header.version = TWEAKS_TRACE_VERSION;
+  header.record_size = sizeof(TweakTraceRecord);
+  header.count = end - begin;
+
+  bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+  for (uint64_t i = begin; ok && i < end; i++) {
+    ok = fwrite(&records[i & (capacity - 1)], sizeof(TweakTraceRecord), 1,
+                fp) == 1;
+  }
+
+  return fclose(fp) == 0 && ok;
+}
+
+// Scintilla notification codes; the replay tool builds without Scintilla.
+#define TWEAKS_SCN_FOCUSIN 2028
+#define TWEAKS_SCN_FOCUSOUT 2029
+
+// Only focus notifications matter to a pass.  Caret moves, restyling, and
+// other updates of an idle editor must not wake the main loop.
+bool trace_event_schedules_pass(TweakTraceType type, uint16_t code) {
+  switch (type) {
+    case TWEAKS_TRACE_SIGNAL:
+      return true;
+    case TWEAKS_TRACE_EDITOR_NOTIFY:
+      return code == TWEAKS_SCN_FOCUSIN || code == TWEAKS_SCN_FOCUSOUT;
+    default:
+      return false;
+  }
+}
+
+char const *trace_type_name(TweakTraceType type) {
+  static char const *names[TWEAKS_TRACE_TYPE_COUNT] = {
+      "signal",
+      "editor-notify",
+      "pass-begin",
+      "pass-end",
+      "notebook",
+      "dirty-all",
+  };
+  return type < TWEAKS_TRACE_TYPE_COUNT ? names[type] : "unknown";
+}
+
+char const *trace_signal_name(TweakSignalKind kind) {
+  static char const *names[TWEAKS_SIGNAL_COUNT] = {
+      "focus",
+      "grab-focus",
+      "grab-notify",
+      "set-focus-child",
+      "switch-page",
+      "page-added",
+      "page-removed",
+      "page-reordered",
+      "state-flags-changed",
+      "change-current-page",
+      "focus-tab",
+      "move-focus-out",
+      "reorder-tab",
+      "select-page",
+      "set-focus",
+  };
+  return kind < TWEAKS_SIGNAL_COUNT ? names[kind] : "unknown";
+}
@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// Event trace format and recorder.  This file must not depend on GTK or
+// Geany, so it can be shared with the offline replay tool.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TWEAKS_TRACE_MAGIC "XTTRACE1"
+#define TWEAKS_TRACE_VERSION 2
+
+enum TweakTraceType {
+  TWEAKS_TRACE_SIGNAL,         // code: TweakSignalKind
+  TWEAKS_TRACE_EDITOR_NOTIFY,  // code: Scintilla notification code
+  TWEAKS_TRACE_PASS_BEGIN,     // value: notebooks to visit
+  TWEAKS_TRACE_PASS_END,       // code: pages visited, value: style writes,
+                               // notebook: kind with focus or NO_FOCUS
+  TWEAKS_TRACE_NOTEBOOK,       // code: current page, value: page count
+  TWEAKS_TRACE_DIRTY_ALL,      // every notebook marked dirty
+
+  TWEAKS_TRACE_TYPE_COUNT,
+};
+
+enum TweakSignalKind {
+  TWEAKS_SIGNAL_FOCUS,
+  TWEAKS_SIGNAL_GRAB_FOCUS,
+  TWEAKS_SIGNAL_GRAB_NOTIFY,
+  TWEAKS_SIGNAL_SET_FOCUS_CHILD,
+  TWEAKS_SIGNAL_SWITCH_PAGE,
+  TWEAKS_SIGNAL_PAGE_ADDED,
+  TWEAKS_SIGNAL_PAGE_REMOVED,
+  TWEAKS_SIGNAL_PAGE_REORDERED,
+  TWEAKS_SIGNAL_STATE_FLAGS_CHANGED,
+  TWEAKS_SIGNAL_CHANGE_CURRENT_PAGE,
+  TWEAKS_SIGNAL_FOCUS_TAB,
+  TWEAKS_SIGNAL_MOVE_FOCUS_OUT,
+  TWEAKS_SIGNAL_REORDER_TAB,
+  TWEAKS_SIGNAL_SELECT_PAGE,
+  TWEAKS_SIGNAL_WINDOW_SET_FOCUS,
+
+  TWEAKS_SIGNAL_COUNT,
+};
+
+#define TWEAKS_TRACE_NO_FOCUS 0xff
+#define TWEAKS_TRACE_NO_PAGE 0xffff
+
+// 16 bytes, stored in host byte order
+struct TweakTraceRecord {
+  uint64_t time_us;  // monotonic clock
+  uint8_t type;      // TweakTraceType
+  uint8_t notebook;  // TweakNotebookKind
+  uint16_t code;
+  uint32_t value;
+};
+
+struct TweakTraceHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t record_size;
+  uint64_t count;
+};
+
+// Main thread only, like the rest of the plugin: records are written in
+// place, so a second writer or a dump() from another thread would tear
+// them.  The oldest records are overwritten when full.
+class TweakTraceRecorder {
+ public:
+  static constexpr size_t capacity = 1 << 16;
+
+  void record(TweakTraceType type, uint8_t notebook, uint16_t code,
+              uint32_t value = 0);
+  bool dump(char const *filename) const;
+  void reset() { head = 0; }
+  uint64_t get_count() const { return head; }
+
+  static uint64_t now_us();
+
+ private:
+  uint64_t head = 0;
+  TweakTraceRecord records[capacity] = {};
+};
+
+extern TweakTraceRecorder tracer;
+
+// Whether an event should schedule a highlight pass.  The plugin and the
+// replay tool share this decision.
+bool trace_event_schedules_pass(TweakTraceType type, uint16_t code);
+
+char const *trace_type_name(TweakTraceType type);
+char const *trace_signal_name(TweakSignalKind kind);
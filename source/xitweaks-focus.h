@@ -0,0 +1,40 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+/* Focus tracking shared with other Geany plugins.
+ *
+ * Xi/Tweaks attaches a GObject to the Geany main window.  It emits
+ * "focus-changed" once per focus transition among notebook pages, after
+ * coalescing, so plugins need not install GTK focus hooks of their own.
+ *
+ *   GObject *service = g_object_get_data(
+ *       G_OBJECT(geany_data->main_widgets->window),
+ *       XITWEAKS_FOCUS_SERVICE_KEY);
+ *   if (service != NULL) {
+ *     g_signal_connect(service, "focus-changed", G_CALLBACK(on_focus), data);
+ *     g_signal_emit_by_name(service, "refresh");
+ *   }
+ *
+ *   void on_focus(GObject *service, gint kind, GtkWidget *page,
+ *                 GtkWidget *widget, gpointer data);
+ *
+ * kind is an XiTweaksFocusKind.  page is the focused notebook page and
+ * widget is the focus widget of the main window; both are NULL when no
+ * notebook has focus.
+ *
+ * Emitting "refresh" after connecting starts tracking if it was off and
+ * emits the current focus.  When Xi/Tweaks is unloaded, "focus-changed"
+ * is emitted with XITWEAKS_FOCUS_NONE before the service goes away.
+ * Disconnect before the plugin is unloaded.
+ */
+
+#define XITWEAKS_FOCUS_SERVICE_KEY "xitweaks-focus-service"
+
+typedef enum {
+  XITWEAKS_FOCUS_NONE = -1,
+  XITWEAKS_FOCUS_SIDEBAR,
+  XITWEAKS_FOCUS_MSGWIN,
+  XITWEAKS_FOCUS_EDITOR,
+  XITWEAKS_FOCUS_OTHER,
+} XiTweaksFocusKind;
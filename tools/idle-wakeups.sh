@@ -0,0 +1,80 @@
+#!/bin/sh
+# SPDX-License-Identifier: GPL-3.0-or-later
+#
+# Reports main loop wakeups caused by the plugin while Geany sits idle.
+#
+# usage: tools/idle-wakeups.sh [seconds] [plugin]
+#
+# Geany runs twice under Xvfb with a scratch config, once for a short
+# warm-up and once for the given time, with one file open and every
+# feature enabled.  Startup work is the same in both runs, so the
+# difference in scheduler batches over the difference in time is the idle
+# wakeup rate.  It should be 0.
+
+set -e
+
+seconds=${1:-30}
+plugin=$(realpath "${2:-build/xi-tweaks.so}")
+warmup=5
+
+if [ "$seconds" -le "$warmup" ]; then
+  echo "seconds must be greater than $warmup" >&2
+  exit 1
+fi
+for cmd in xvfb-run geany timeout; do
+  if ! command -v "$cmd" > /dev/null; then
+    echo "$cmd not found" >&2
+    exit 1
+  fi
+done
+
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+mkdir -p "$tmp/config/plugins/xitweaks"
+cat > "$tmp/config/geany.conf" <<CONF
+[plugins]
+load_plugins=true
+active_plugins=$plugin;
+CONF
+cat > "$tmp/config/plugins/xitweaks/xitweaks.conf" <<CONF
+[tweaks]
+sidebar_focus_enabled=true
+notebook_focus_enabled=true
+inactive_window_dimmed=true
+doc_state_enabled=true
+tab_activity_enabled=true
+CONF
+printf 'int main() {\n  return 0;\n}\n' > "$tmp/idle.c"
+
+# prints "<seconds> <batches>" for one idle run
+run() {
+  # geany saves and unloads plugins on SIGTERM
+  XITWEAKS_STATS_FILE="$tmp/stats.txt" xvfb-run -a \
+    timeout -s TERM "$1" geany -c "$tmp/config" -i "$tmp/idle.c" \
+    > /dev/null 2>&1 || true
+
+  if [ ! -f "$tmp/stats.txt" ]; then
+    echo "no statistics written; is the plugin loaded?" >&2
+    exit 1
+  fi
+  # "batches over budget" follows "batches"; match the count line only
+  awk '/^Collected over/ { t = $3 } $1 == "batches" && NF == 2 { b = $2 }
+       END {
+         if (b !~ /^[0-9]+$/) {
+           print "no scheduler batches in the statistics" > "/dev/stderr"
+           exit 1
+         }
+         print t, b
+       }' "$tmp/stats.txt" || exit 1
+  rm -f "$tmp/stats.txt"
+}
+
+short=$(run "$warmup")
+long=$(run "$seconds")
+
+echo "$short $long" | awk '{
+  dt = $3 - $1
+  db = $4 - $2
+  printf "idle for %.1f s: %d wakeups, %.3f per second\n", dt, db, db / dt
+}'